@@ -5,24 +5,81 @@
 
 	This program demonstrates the following tactics:
 		A variable number of command line arguments
-		creating an unordered map from lib
+		an open-addressing (Robin Hood) hash set in place of the lib's unordered map
 		reading data from a file
+		memory-mapping a file & indexing it with string_views (zero-copy)
+		a binary on-disk hash index that is mapped & queried without a rebuild
 
 	1) A dictionary is created from the external file, dict.txt
-	2) space-delineated books as CMD args are read in
+		dict.txt is mapped with mmap; keys are views into the mapped bytes, nothing is copied
+		line endings (\n or \r\n) are normalized away once, while loading
+		with --index, the precompiled table dict.idx is mapped instead (rebuilt if dict.txt changed)
+		with --dawg, words are held in a minimal automaton (DAWG) instead of a hash table
+			- a few MB for the whole list, & able to list every word with a given prefix
+	2) books as CMD args are read in
+		words are runs of letters, split out & lowercased by a SIMD (SSE2/AVX2) tokenizer
+		books are split into chunks & scanned by a pool of worker threads (--threads N)
+		results are still printed in argument order
+		with --top K, each distinct missing word is counted & only the K most frequent are reported
+		with --suggest, missing words come with the closest dictionary words (edit distance 1-2)
+		with --stdin, text is streamed from standard input through a fixed-size buffer instead
+			- with --watch, dict.txt is reloaded in the background whenever it changes, without pausing lookups
+		with --bench, a synthetic corpus is generated & each phase is timed instead (JSON report)
 	3) words found in the books but not in the dictionary are printed to screen
 
 	Designed and tested on UbuntuLinux w/ g++ compiler
+	string_view requires C++17 (default for g++ 11+); the worker pool needs the pthread link:
+		g++ -O2 -std=c++17 -pthread dictionary-lookup.cc
 */
 
 //include books as follows:
 	//  ./executable book1.txt book2.txt ... 
-	//	book files should be space-delineated
+	//	book words may be separated by any whitespace or punctuation
 	//	include line-delineated dictionary file in working directory as "dict.txt"
+//precompiled dictionary index:
+	//  ./executable --compile					writes dict.idx & dict.dawg from dict.txt & exits
+	//  ./executable --index book1.txt ...		maps dict.idx; recompiles it first if missing or stale
+	//  ./executable --dawg [--index] ...			use the DAWG backend (--index: map dict.dawg, recompiling it if stale)
+	//  ./executable --prefix P					list the dictionary words starting with P & exit
+	//  ./executable --threads N ...				scan books with N worker threads (default: one per core)
+	//  ./executable --bloom ...					put a blocked Bloom filter in front of the table & report its accuracy
+	//  ./executable --top K ...					report the K most frequent missing words with counts, not every occurrence
+	//  ./executable --suggest ...				suggest dictionary words within edit distance 2 of each missing word
+	//  ./executable --stats ...					also report table memory, load factor & probes per lookup
+//benchmark mode (no books; combine with --dawg, --index, --bloom, --threads to compare setups):
+	//  ./executable --bench [--bench-words N] [--miss-ratio R] [--repeat K] [--seed S]
+	//		times dictionary load, tokenizing & lookup separately; prints one JSON object
+//streaming (pipe) mode:
+	//  cat logs | ./executable --stdin			missing words to stdout, one per line; no banner, no colors
+	//  tail -f log | ./executable --stdin --watch	pick up a new dict.txt (replaced via mv) without restarting; reloads noted on stderr
 
 #include <iostream>
-#include <unordered_map>
 #include <fstream> 			//file i/o
+#include <string_view>		//zero-copy keys into the mapped dictionary
+#include <cstring>			//memchr, memcmp
+#include <memory>			//unique_ptr
+#include <functional>		//function - visiting the words of any backend
+#include <unordered_map>	//DAWG construction registry
+#include <vector>
+#include <cstdio>			//rename
+#include <cstdlib>			//atoi
+#include <thread>			//book scanning worker pool
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cmath>			//pow
+#include <cerrno>			//EINTR
+#include <algorithm>		//partial_sort, sort, unique
+#include <chrono>			//suggestion index build & query timing, benchmark
+#include <random>			//benchmark corpus
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>		//SSE2/AVX2 tokenizer
+#endif
+#include <fcntl.h>			//open
+#include <sys/mman.h>		//mmap, munmap, madvise
+#include <sys/stat.h>		//fstat
+#include <sys/resource.h>	//getrusage - benchmark peak memory
+#include <unistd.h>			//close
 using namespace std;
 
 inline void textcolor(char c){
@@ -42,47 +99,1591 @@ int endProgram(int v){	//eloquently abort main()
 	return v;
 }
 
+//private memory map of an entire file; unmapped when the object leaves scope
+//the kernel pages the file in lazily, so "loading" costs no copies & no per-word allocations
+//a writable map is copy-on-write: edits (e.g. lowercasing) stay in memory & never reach the file
+class MappedFile {
+private:
+	char* p;
+	size_t length;
+
+public:
+	MappedFile(const char* path, bool writable = false) : p(nullptr), length(0){
+		int fd = open(path, O_RDONLY);
+		if(fd < 0){return;}
+		struct stat st;
+		if(fstat(fd, &st) == 0 && st.st_size > 0){
+			void* m = mmap(nullptr, st.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+			if(m != MAP_FAILED){
+				p = static_cast<char*>(m);
+				length = st.st_size;
+				madvise(m, length, MADV_SEQUENTIAL); //we read front-to-back exactly once
+			}
+		}
+		close(fd);	//the mapping stays valid after the descriptor is closed
+	}
+	~MappedFile(){ if(p){munmap(p, length);} }
+	MappedFile(const MappedFile&) = delete;				//a mapping has exactly one owner
+	MappedFile& operator =(const MappedFile&) = delete;
+
+	bool isOpen() const{ return p != nullptr; }
+	const char* data() const{ return p; }
+	char* data(){ return p; }	//only writable if mapped so
+	size_t size() const{ return length; }
+};
+
+//number of lines in a mapped file - lets callers size their tables once
+uint64_t countLines(const MappedFile& file){
+	const char* end = file.data() + file.size();
+	uint64_t lines = 0;
+	for(const char* c = file.data(); (c = static_cast<const char*>(memchr(c, '\n', end - c))); c++){lines++;}
+	return lines + 1;
+}
+
+//call visit(word) for every line of a mapped dictionary, up to the first empty line
+//GDB reveals dict.txt lines end in \r\n - the \r is dropped here, once, so lookups never need a second try
+template<typename F>
+void forEachLine(const MappedFile& file, F visit){
+	const char* cur = file.data();
+	const char* end = cur + file.size();
+	while(cur < end){
+		const char* nl = static_cast<const char*>(memchr(cur, '\n', end - cur));
+		if(!nl){nl = end;}
+		const char* last = (nl > cur && nl[-1] == '\r') ? nl - 1 : nl;
+		if(last == cur){break;}	//Abort if we reach an empty line
+		visit(string_view(cur, last - cur));
+		cur = nl + 1;
+	}
+}
+
+//FNV-1a, finished with a murmur3 avalanche so the low bits (the table index) are well mixed
+//a fixed hash - tables written to disk remain valid across builds & machines (std::hash makes no such promise)
+//split in two so a word's hash can be built up a piece at a time (the suggestion index's deletes)
+const uint64_t hashSeed = 14695981039346656037ull;
+inline uint64_t hashAppend(uint64_t h, const char* s, size_t n){
+	for(size_t i = 0; i < n; i++){ h = (h ^ static_cast<unsigned char>(s[i])) * 1099511628211ull; }
+	return h;
+}
+inline uint64_t hashFinish(uint64_t h){
+	h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+	return h ^ (h >> 33);
+}
+inline uint64_t hashWord(string_view w){ return hashFinish(hashAppend(hashSeed, w.data(), w.size())); }
+
+//what every dictionary backend answers
+class Dictionary {
+public:
+	virtual ~Dictionary(){}
+	virtual bool contains(string_view w, uint64_t h) const = 0;	//h = hashWord(w), computed once by the caller
+	virtual uint64_t size() const = 0;
+	virtual uint64_t memoryBytes() const = 0;
+	virtual void forEachWord(const function<void(string_view)>& visit) const = 0;	//views last only for the call
+	bool contains(string_view w) const{ return contains(w, hashWord(w)); }
+};
+
+/* An open-addressing hash set of words (Robin Hood probing)
+	replaces the node-based unordered_map: one flat array, no per-word heap nodes
+	keys are not stored - each slot keeps an offset & length into a caller-owned byte buffer
+	(the mapped dict.txt), plus the upper 32 bits of the hash so most mismatches never touch the bytes
+	Robin Hood insertion keeps probe sequences short & lets a miss stop early	*/
+class FlatWordSet : public Dictionary {
+public:
+	struct Slot {
+		uint32_t tag;			//upper half of the word's hash
+		uint32_t offset;		//word position in the base buffer
+		uint16_t length;
+		uint16_t distance;		//1 + displacement from the home slot; 0 marks an empty slot
+	};
+	struct ProbeStats {
+		double averageHit, averageMiss;	//slots inspected per successful / unsuccessful lookup
+		uint64_t longestHit;
+	};
+
+private:
+	vector<Slot> owned;		//table storage when built in memory
+	const Slot* slots;		//owned.data() or a mapped table
+	uint64_t mask;
+	uint64_t count;
+	const char* base;
+
+public:
+	FlatWordSet() : slots(nullptr), mask(0), count(0), base(nullptr){}
+	FlatWordSet(const FlatWordSet&) = delete;	//slots may point into owned
+	FlatWordSet& operator =(const FlatWordSet&) = delete;
+
+	//start an empty table sized for expectedWords at a load factor of at most 7/8
+	void reset(const char* wordBase, uint64_t expectedWords){
+		uint64_t n = 16;
+		while(n * 7 < expectedWords * 8){n *= 2;}
+		owned.assign(n, Slot{0, 0, 0, 0});
+		slots = owned.data();
+		mask = n - 1;
+		count = 0;
+		base = wordBase;
+	}
+
+	//view a table that lives elsewhere (a mapped index); nothing is copied
+	void attach(const Slot* table, uint64_t slotCount, uint64_t words, const char* wordBase){
+		owned.clear();
+		slots = table;
+		mask = slotCount - 1;
+		count = words;
+		base = wordBase;
+	}
+
+	//w must point into the base buffer (< 4 GiB); returns false for a duplicate or an over-long word
+	//the table is sized by reset() & does not grow
+	bool insert(string_view w){
+		if(w.size() > UINT16_MAX){return false;}
+		uint64_t h = hashWord(w);
+		Slot cur{static_cast<uint32_t>(h >> 32), static_cast<uint32_t>(w.data() - base), static_cast<uint16_t>(w.size()), 1};
+		for(uint64_t i = h & mask;; i = (i + 1) & mask, cur.distance++){
+			Slot& s = owned[i];
+			if(s.distance == 0){ s = cur; count++; return true; }
+			if(s.tag == cur.tag && s.length == cur.length && memcmp(base + s.offset, base + cur.offset, cur.length) == 0){return false;}
+			if(s.distance < cur.distance){swap(s, cur);}	//rob the richer slot; keep placing the evicted one
+		}
+	}
+
+	bool contains(string_view w) const{ return contains(w, hashWord(w)); }
+
+	//for callers that already hashed w (see hashWord)
+	bool contains(string_view w, uint64_t h) const override{
+		uint32_t tag = static_cast<uint32_t>(h >> 32);
+		for(uint64_t i = h & mask, d = 1;; i = (i + 1) & mask, d++){
+			const Slot& s = slots[i];
+			if(s.distance < d){return false;}	//empty, or a word closer to its home - w cannot be further along
+			if(s.tag == tag && s.length == w.size() && memcmp(base + s.offset, w.data(), w.size()) == 0){return true;}
+		}
+	}
+
+	//call visit(word) for every word, in table order
+	template<typename F>
+	void forEach(F visit) const{
+		for(uint64_t i = 0; i <= mask; i++){
+			if(slots[i].distance){visit(string_view(base + slots[i].offset, slots[i].length));}
+		}
+	}
+	void forEachWord(const function<void(string_view)>& visit) const override{ forEach(visit); }
+
+	uint64_t size() const override{ return count; }
+	uint64_t slotCount() const{ return mask + 1; }
+	const Slot* table() const{ return slots; }
+	uint64_t memoryBytes() const override{ return slotCount() * sizeof(Slot); }	//keys live in the (mapped) base buffer
+	double loadFactor() const{ return double(count) / slotCount(); }
+
+	//exact probe lengths, measured from the table itself rather than from sampled lookups:
+	//a hit on a word inspects `distance` slots; a miss homed at slot i stops at the first slot
+	//whose distance is smaller than the probe position
+	ProbeStats probeStats() const{
+		ProbeStats st{0, 0, 0};
+		uint64_t n = slotCount();
+		for(uint64_t i = 0; i < n; i++){
+			st.averageHit += slots[i].distance;
+			if(slots[i].distance > st.longestHit){st.longestHit = slots[i].distance;}
+			uint64_t d = 1;
+			while(slots[(i + d - 1) & mask].distance >= d){d++;}
+			st.averageMiss += d;
+		}
+		st.averageHit = count ? st.averageHit / count : 0;
+		st.averageMiss /= n;
+		return st;
+	}
+};
+
+//index every line of the mapped dictionary; keys are offsets into the mapping, never copies,
+//so the mapping must outlive the set
+uint64_t loadDictionary(const MappedFile& file, FlatWordSet& dictionary){
+	dictionary.reset(file.data(), countLines(file));	//sized once - the table never rehashes
+	forEachLine(file, [&](string_view word){ dictionary.insert(word); });
+	return dictionary.size();
+}
+
+//size & mtime of a source file - compiled files record it to notice when dict.txt changes
+struct SourceStamp {
+	uint64_t size;
+	int64_t mtimeSec, mtimeNsec;
+
+	static bool of(const char* path, SourceStamp& s){
+		struct stat st;
+		if(stat(path, &st) != 0){return false;}
+		s.size = st.st_size;
+		s.mtimeSec = st.st_mtim.tv_sec;
+		s.mtimeNsec = st.st_mtim.tv_nsec;
+		return true;
+	}
+
+	bool sameAs(const SourceStamp& o) const{ return o.size == size && o.mtimeSec == mtimeSec && o.mtimeNsec == mtimeNsec; }
+
+	bool matches(const char* path) const{
+		SourceStamp now;
+		if(!of(path, now)){return true;}	//no source to compare against - trust the compiled file
+		return sameAs(now);
+	}
+};
+
+/* Binary dictionary index (dict.idx)
+	[IndexHeader][FlatWordSet::Slot x slotCount][dict.txt bytes]
+	the slots are a FlatWordSet table whose offsets point into the copy of dict.txt that follows
+	the header records size & mtime of the dict.txt it was compiled from	*/
+struct IndexHeader {
+	char magic[8];
+	SourceStamp source;
+	uint64_t wordCount;
+	uint64_t slotCount;
+	uint64_t blobSize;
+};
+const char indexMagic[8] = {'D','I','C','T','I','D','X','3'};
+
+//compile dict.txt into a binary index; written to a temporary & renamed so readers never see half a file
+bool compileIndex(const char* source, const char* target){
+	MappedFile dict(source);
+	IndexHeader h;
+	if(!dict.isOpen() || !SourceStamp::of(source, h.source)){return false;}
+
+	FlatWordSet words;
+	loadDictionary(dict, words);
+
+	memcpy(h.magic, indexMagic, sizeof(indexMagic));
+	h.wordCount = words.size();
+	h.slotCount = words.slotCount();
+	h.blobSize = dict.size();
+
+	string tmp = string(target) + ".tmp";
+	ofstream out(tmp, ios::binary | ios::trunc);
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(reinterpret_cast<const char*>(words.table()), words.memoryBytes());
+	out.write(dict.data(), dict.size());
+	out.close();
+	if(!out){ remove(tmp.c_str()); return false; }
+	return rename(tmp.c_str(), target) == 0;
+}
+
+//a compiled index, mapped & queried in place - opening it costs one mmap, whatever the dictionary size
+class DictionaryIndex {
+private:
+	MappedFile file;
+	const IndexHeader* header;
+	FlatWordSet set;
+
+public:
+	DictionaryIndex(const char* path) : file(path), header(nullptr){
+		if(!file.isOpen() || file.size() < sizeof(IndexHeader)){return;}
+		const IndexHeader* h = reinterpret_cast<const IndexHeader*>(file.data());
+		if(memcmp(h->magic, indexMagic, sizeof(indexMagic)) != 0 || h->slotCount == 0 || (h->slotCount & (h->slotCount - 1))){return;}
+		if(file.size() != sizeof(IndexHeader) + h->slotCount * sizeof(FlatWordSet::Slot) + h->blobSize){return;} //truncated or corrupt
+		madvise(const_cast<char*>(file.data()), file.size(), MADV_RANDOM);	//lookups hop around the table
+		header = h;
+		const FlatWordSet::Slot* slots = reinterpret_cast<const FlatWordSet::Slot*>(file.data() + sizeof(IndexHeader));
+		set.attach(slots, h->slotCount, h->wordCount, reinterpret_cast<const char*>(slots + h->slotCount));
+	}
+
+	bool isValid() const{ return header != nullptr; }
+	const FlatWordSet& words() const{ return set; }
+
+	//true if the index was compiled from the current contents of source (by size & mtime)
+	bool isFreshFor(const char* source) const{ return header->source.matches(source); }
+};
+
+/* Minimal acyclic word automaton (DAWG) backend (--dawg)
+	a trie whose identical suffix subtrees are merged, so common prefixes AND suffixes are stored once
+	built in one pass over the sorted words (Daciuk et al. incremental construction): once a word
+	is added, the nodes left behind by the previous word can never change & are merged with an
+	identical registered node or registered themselves
+	flattened into two arrays: each node's edges sit together, sorted by label, & each edge is one
+	32-bit word - label (8 bits) | target is final (1 bit) | target node (23 bits)
+	each node also keeps a bitmap of its a-z labels, so stepping on a letter is a popcount, not a search
+	answers exact lookups & prefix enumeration; saved to & mapped from dict.dawg	*/
+class Dawg : public Dictionary {
+public:
+	struct Node {
+		uint32_t firstEdge;		//edges of node n are edges[nodes[n].firstEdge .. nodes[n+1].firstEdge)
+		uint32_t letters;		//bit i: an edge labelled 'a'+i; bit 31: some label is not a-z
+	};
+
+private:
+	vector<Node> ownedNodes;					//storage when built in memory
+	vector<uint32_t> ownedEdges;
+	const Node* table;
+	const uint32_t* edges;
+	uint64_t nodes, edgeCount, words;
+
+	static const unsigned targetShift = 9;
+	static const uint32_t finalBit = 1u << 8, otherLabels = 1u << 31;
+
+	//the edge leaving node with label c, or -1
+	int64_t step(uint32_t node, unsigned char c) const{
+		const Node& n = table[node];
+		unsigned letter = c - 'a';
+		if(letter < 26 && !(n.letters & otherLabels)){	//edges are exactly the set letters, in order
+			if(!(n.letters & (1u << letter))){return -1;}
+			return n.firstEdge + __builtin_popcount(n.letters & ((1u << letter) - 1));
+		}
+		for(uint32_t e = n.firstEdge; e < table[node + 1].firstEdge; e++){
+			unsigned char label = edges[e] & 0xff;
+			if(label == c){return e;}
+			if(label > c){break;}
+		}
+		return -1;
+	}
+
+	template<typename F>
+	void walk(uint32_t node, string& prefix, F& visit) const{
+		for(uint32_t e = table[node].firstEdge; e < table[node + 1].firstEdge; e++){
+			prefix.push_back(static_cast<char>(edges[e] & 0xff));
+			if(edges[e] & finalBit){visit(string_view(prefix));}
+			walk(edges[e] >> targetShift, prefix, visit);
+			prefix.pop_back();
+		}
+	}
+
+public:
+	Dawg() : table(nullptr), edges(nullptr), nodes(0), edgeCount(0), words(0){}
+	Dawg(const Dawg&) = delete;	//arrays may be owned
+	Dawg& operator =(const Dawg&) = delete;
+
+	//sorted must be sorted & free of duplicates; false if the automaton outgrows 2^23 nodes
+	bool build(const vector<string_view>& sorted){
+		struct State {
+			vector<pair<unsigned char,uint32_t>> out;	//in label order, as words arrive sorted
+			bool final = false;
+		};
+		struct Pending { uint32_t parent, child; };		//the newest word's path, not yet minimized
+		vector<State> build(1);
+		vector<uint32_t> freeNodes;
+		unordered_map<string,uint32_t> registry;		//node signature -> its one registered copy
+		vector<Pending> unchecked;
+
+		auto signature = [&](uint32_t n){
+			string s(1, build[n].final ? 'F' : 'N');
+			for(const pair<unsigned char,uint32_t>& e : build[n].out){
+				s.push_back(static_cast<char>(e.first));
+				s.append(reinterpret_cast<const char*>(&e.second), sizeof(e.second));
+			}
+			return s;
+		};
+		auto minimize = [&](size_t downTo){	//merge or register the pending nodes deeper than downTo
+			while(unchecked.size() > downTo){
+				Pending p = unchecked.back();
+				unchecked.pop_back();
+				string sig = signature(p.child);
+				unordered_map<string,uint32_t>::iterator it = registry.find(sig);
+				if(it == registry.end()){ registry.emplace(move(sig), p.child); continue; }
+				build[p.parent].out.back().second = it->second;	//the pending child is always its parent's last edge
+				build[p.child] = State();
+				freeNodes.push_back(p.child);
+			}
+		};
+
+		string_view previous;
+		for(string_view w : sorted){
+			size_t common = 0;
+			while(common < w.size() && common < previous.size() && w[common] == previous[common]){common++;}
+			minimize(common);
+			uint32_t node = unchecked.empty() ? 0 : unchecked.back().child;
+			for(size_t i = common; i < w.size(); i++){
+				uint32_t n;
+				if(freeNodes.empty()){ n = build.size(); build.emplace_back(); }
+				else{ n = freeNodes.back(); freeNodes.pop_back(); }
+				build[node].out.emplace_back(static_cast<unsigned char>(w[i]), n);
+				unchecked.push_back(Pending{node, n});
+				node = n;
+			}
+			build[node].final = true;
+			previous = w;
+		}
+		minimize(0);
+
+		//flatten, numbering nodes depth first so a walk mostly moves forward through nearby memory
+		vector<uint32_t> id(build.size(), UINT32_MAX);
+		vector<uint32_t> order;
+		vector<uint32_t> stack(1, 0);
+		while(!stack.empty()){
+			uint32_t n = stack.back();
+			stack.pop_back();
+			if(id[n] != UINT32_MAX){continue;}
+			id[n] = order.size();
+			order.push_back(n);
+			for(size_t e = build[n].out.size(); e-- > 0;){stack.push_back(build[n].out[e].second);}	//first label on top
+		}
+		if(order.size() >= (1u << (32 - targetShift))){return false;}
+		ownedNodes.clear();
+		ownedEdges.clear();
+		for(uint32_t n : order){
+			Node node{static_cast<uint32_t>(ownedEdges.size()), 0};
+			for(const pair<unsigned char,uint32_t>& e : build[n].out){
+				unsigned letter = e.first - 'a';
+				node.letters |= (letter < 26) ? 1u << letter : otherLabels;
+				ownedEdges.push_back(e.first | (build[e.second].final ? finalBit : 0) | (id[e.second] << targetShift));
+			}
+			ownedNodes.push_back(node);
+		}
+		ownedNodes.push_back(Node{static_cast<uint32_t>(ownedEdges.size()), 0});	//end marker
+		table = ownedNodes.data();
+		edges = ownedEdges.data();
+		nodes = order.size();
+		edgeCount = ownedEdges.size();
+		words = sorted.size();
+		return true;
+	}
+
+	//view arrays that live elsewhere (a mapped dict.dawg); nothing is copied
+	void attach(const Node* nodeTable, uint64_t nodeCount, const uint32_t* edgeTable, uint64_t edgeTotal, uint64_t wordCount){
+		ownedNodes.clear();
+		ownedEdges.clear();
+		table = nodeTable;
+		edges = edgeTable;
+		nodes = nodeCount;
+		edgeCount = edgeTotal;
+		words = wordCount;
+	}
+
+	using Dictionary::contains;
+	bool contains(string_view w, uint64_t) const override{
+		uint32_t node = 0;
+		bool final = false;
+		for(unsigned char c : w){
+			int64_t e = step(node, c);
+			if(e < 0){return false;}
+			node = edges[e] >> targetShift;
+			final = edges[e] & finalBit;
+		}
+		return final;
+	}
+
+	//call visit(word) for every word starting with prefix, in alphabetical order
+	template<typename F>
+	void forEachWithPrefix(string_view prefix, F visit) const{
+		uint32_t node = 0;
+		bool final = false;
+		for(unsigned char c : prefix){
+			int64_t e = step(node, c);
+			if(e < 0){return;}
+			node = edges[e] >> targetShift;
+			final = edges[e] & finalBit;
+		}
+		string word(prefix);
+		if(final){visit(string_view(word));}
+		walk(node, word, visit);
+	}
+	void forEachWord(const function<void(string_view)>& visit) const override{ forEachWithPrefix("", visit); }
+
+	uint64_t size() const override{ return words; }
+	uint64_t nodeCount() const{ return nodes; }
+	uint64_t edgeTotal() const{ return edgeCount; }
+	const Node* nodeTable() const{ return table; }
+	const uint32_t* edgeTable() const{ return edges; }
+	uint64_t memoryBytes() const override{ return (nodes + 1) * sizeof(Node) + edgeCount * sizeof(uint32_t); }
+};
+
+//every word of a mapped dictionary, sorted & deduplicated - the order a Dawg is built from
+vector<string_view> sortedWords(const MappedFile& file){
+	vector<string_view> sorted;
+	sorted.reserve(countLines(file));
+	forEachLine(file, [&](string_view word){ sorted.push_back(word); });
+	sort(sorted.begin(), sorted.end());
+	sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+	return sorted;
+}
+
+/* Saved automaton (dict.dawg)
+	[DawgHeader][Dawg::Node x nodeCount + 1][edges: edgeCount x uint32]	*/
+struct DawgHeader {
+	char magic[8];
+	SourceStamp source;
+	uint64_t wordCount;
+	uint64_t nodeCount;
+	uint64_t edgeCount;
+};
+const char dawgMagic[8] = {'D','I','C','T','D','W','G','1'};
+
+//compile dict.txt into dict.dawg; written to a temporary & renamed like dict.idx
+bool compileDawg(const char* source, const char* target){
+	MappedFile dict(source);
+	DawgHeader h;
+	if(!dict.isOpen() || !SourceStamp::of(source, h.source)){return false;}
+	Dawg dawg;
+	if(!dawg.build(sortedWords(dict))){return false;}
+
+	memcpy(h.magic, dawgMagic, sizeof(dawgMagic));
+	h.wordCount = dawg.size();
+	h.nodeCount = dawg.nodeCount();
+	h.edgeCount = dawg.edgeTotal();
+
+	string tmp = string(target) + ".tmp";
+	ofstream out(tmp, ios::binary | ios::trunc);
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(reinterpret_cast<const char*>(dawg.nodeTable()), (h.nodeCount + 1) * sizeof(Dawg::Node));
+	out.write(reinterpret_cast<const char*>(dawg.edgeTable()), h.edgeCount * sizeof(uint32_t));
+	out.close();
+	if(!out){ remove(tmp.c_str()); return false; }
+	return rename(tmp.c_str(), target) == 0;
+}
+
+//a saved automaton, mapped & walked in place
+class DawgFile {
+private:
+	MappedFile file;
+	const DawgHeader* header;
+	Dawg dawg;
+
+public:
+	DawgFile(const char* path) : file(path), header(nullptr){
+		if(!file.isOpen() || file.size() < sizeof(DawgHeader)){return;}
+		const DawgHeader* h = reinterpret_cast<const DawgHeader*>(file.data());
+		if(memcmp(h->magic, dawgMagic, sizeof(dawgMagic)) != 0){return;}
+		if(file.size() != sizeof(DawgHeader) + (h->nodeCount + 1) * sizeof(Dawg::Node) + h->edgeCount * sizeof(uint32_t)){return;} //truncated or corrupt
+		header = h;
+		const Dawg::Node* nodeTable = reinterpret_cast<const Dawg::Node*>(file.data() + sizeof(DawgHeader));
+		dawg.attach(nodeTable, h->nodeCount, reinterpret_cast<const uint32_t*>(nodeTable + h->nodeCount + 1), h->edgeCount, h->wordCount);
+	}
+
+	bool isValid() const{ return header != nullptr; }
+	const Dawg& words() const{ return dawg; }
+	bool isFreshFor(const char* source) const{ return header->source.matches(source); }
+};
+
+//map a compiled file (DictionaryIndex or DawgFile), recompiling it from source whenever it is missing, corrupt or stale
+template<typename T>
+unique_ptr<T> openCompiled(const char* source, const char* target, bool (*compile)(const char*, const char*)){
+	unique_ptr<T> compiled(new T(target));
+	if(compiled->isValid() && compiled->isFreshFor(source)){return compiled;}
+	compiled.reset();	//unmap before the file is replaced
+	if(!compile(source, target)){return nullptr;}
+	compiled.reset(new T(target));
+	return compiled->isValid() ? move(compiled) : nullptr;
+}
+
+/* Book tokenizer
+	a word is a run of ASCII letters (bytes >= 0x80 count as letters so UTF-8 words stay whole)
+	everything else - spaces, newlines, tabs, digits, punctuation - separates words
+	the buffer is lowercased in place during the same pass & tokens are views into it, so nothing is allocated
+	16 (SSE2) or 32 (AVX2) bytes are classified per step; the instruction set is picked once at runtime	*/
+inline bool isWordByte(unsigned char c){
+	return static_cast<unsigned char>((c | 0x20) - 'a') < 26 || c >= 0x80;
+}
+
+//tracks whether the scan is inside a word across blocks; fed one bitmask (1 = word byte) per block
+struct TokenScanner {
+	char* start = nullptr;	//first byte of the open word, if any
+	uint32_t inWord = 0;	//1 if the previous block ended inside a word
+
+	template<typename F>
+	__attribute__((always_inline)) inline void consume(uint32_t mask, unsigned width, char* block, F& visit){
+		uint32_t edges = (mask ^ ((mask << 1) | inWord));	//bit i set where a word starts or ends
+		if(width < 32){edges &= (1u << width) - 1;}
+		while(edges){
+			unsigned i = __builtin_ctz(edges);
+			edges &= edges - 1;
+			if(start){ visit(string_view(start, block + i - start)); start = nullptr; }
+			else{start = block + i;}
+		}
+		inWord = (mask >> (width - 1)) & 1;
+	}
+
+	//plain byte-at-a-time scan; handles whole buffers on other CPUs & the tail on x86
+	template<typename F>
+	void scalar(char* cur, char* end, F& visit){
+		for(; cur < end; cur++){
+			unsigned char c = *cur;
+			bool word = isWordByte(c);
+			if(static_cast<unsigned char>(c - 'A') < 26){*cur = c | 0x20;}
+			if(word && !start){start = cur;}
+			else if(!word && start){ visit(string_view(start, cur - start)); start = nullptr; }
+		}
+		inWord = start != nullptr;
+	}
+
+	template<typename F>
+	void finish(char* end, F& visit){
+		if(start){ visit(string_view(start, end - start)); start = nullptr; }
+	}
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+template<typename F>
+void tokenizeSSE2(char* cur, char* end, F& visit){
+	TokenScanner scan;
+	const __m128i upperLo = _mm_set1_epi8('A' - 1), upperHi = _mm_set1_epi8('Z' + 1);
+	const __m128i lowerLo = _mm_set1_epi8('a' - 1), lowerHi = _mm_set1_epi8('z' + 1);
+	const __m128i caseBit = _mm_set1_epi8(0x20), zero = _mm_setzero_si128();
+	for(; end - cur >= 16; cur += 16){
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+		__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, upperLo), _mm_cmplt_epi8(v, upperHi));	//signed compares: bytes >= 0x80 are never upper
+		v = _mm_or_si128(v, _mm_and_si128(upper, caseBit));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(cur), v);
+		__m128i word = _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi8(v, lowerLo), _mm_cmplt_epi8(v, lowerHi)), _mm_cmplt_epi8(v, zero));
+		scan.consume(_mm_movemask_epi8(word), 16, cur, visit);
+	}
+	scan.scalar(cur, end, visit);
+	scan.finish(end, visit);
+}
+
+template<typename F>
+__attribute__((target("avx2"))) void tokenizeAVX2(char* cur, char* end, F& visit){
+	TokenScanner scan;
+	const __m256i upperLo = _mm256_set1_epi8('A' - 1), upperHi = _mm256_set1_epi8('Z' + 1);
+	const __m256i lowerLo = _mm256_set1_epi8('a' - 1), lowerHi = _mm256_set1_epi8('z' + 1);
+	const __m256i caseBit = _mm256_set1_epi8(0x20), zero = _mm256_setzero_si256();
+	for(; end - cur >= 32; cur += 32){
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur));
+		__m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, upperLo), _mm256_cmpgt_epi8(upperHi, v));
+		v = _mm256_or_si256(v, _mm256_and_si256(upper, caseBit));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(cur), v);
+		__m256i word = _mm256_or_si256(_mm256_and_si256(_mm256_cmpgt_epi8(v, lowerLo), _mm256_cmpgt_epi8(lowerHi, v)), _mm256_cmpgt_epi8(zero, v));
+		scan.consume(static_cast<uint32_t>(_mm256_movemask_epi8(word)), 32, cur, visit);
+	}
+	scan.scalar(cur, end, visit);
+	scan.finish(end, visit);
+}
+#endif
+
+//lowercase [cur, end) in place & call visit(word) for every word in it
+template<typename F>
+void tokenize(char* cur, char* end, F visit){
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	if(hasAVX2){ tokenizeAVX2(cur, end, visit); }
+	else{ tokenizeSSE2(cur, end, visit); }
+#else
+	TokenScanner scan;
+	scan.scalar(cur, end, visit);
+	scan.finish(end, visit);
+#endif
+}
+
+/* Blocked Bloom filter
+	an optional pre-check (--bloom) that rejects most absent words without touching the hash table
+	every word sets k bits inside a single 64-byte block, so a query costs one cache line
+	built from the loaded dictionary; never gives a false negative	*/
+class BloomFilter {
+private:
+	struct alignas(64) Block { uint64_t w[8]; };
+	static const int probes = 7;		//bits set per word; near optimal for 10 bits per word
+	vector<Block> blocks;
+
+	size_t blockIndex(uint64_t h) const{
+		uint64_t g = h * 0x9e3779b97f4a7c15ull;	//re-mix: the table already uses the low & high bits of h
+		return ((g >> 32) * blocks.size()) >> 32;
+	}
+	static uint64_t bitSource(uint64_t h){ return (h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ull; }	//9 bits per probe
+
+public:
+	void build(const Dictionary& dictionary, unsigned bitsPerWord = 10){
+		blocks.assign((dictionary.size() * bitsPerWord + 511) / 512 + 1, Block{{0}});
+		dictionary.forEachWord([&](string_view w){
+			uint64_t h = hashWord(w);
+			Block& b = blocks[blockIndex(h)];
+			uint64_t bits = bitSource(h);
+			for(int i = 0; i < probes; i++, bits >>= 9){ b.w[(bits >> 6) & 7] |= 1ull << (bits & 63); }
+		});
+	}
+
+	bool mayContain(uint64_t h) const{
+		const Block& b = blocks[blockIndex(h)];
+		uint64_t bits = bitSource(h);
+		for(int i = 0; i < probes; i++, bits >>= 9){
+			if(!(b.w[(bits >> 6) & 7] & (1ull << (bits & 63)))){return false;}
+		}
+		return true;
+	}
+
+	uint64_t memoryBytes() const{ return blocks.size() * sizeof(Block); }
+
+	//chance that an absent word passes: a query lands in a uniformly random block
+	//& must find all k of its bits set there, so average (fill of the block)^k over blocks
+	double estimatedFalsePositiveRate() const{
+		double sum = 0;
+		for(const Block& b : blocks){
+			int set = 0;
+			for(uint64_t w : b.w){set += __builtin_popcountll(w);}
+			sum += pow(set / 512.0, probes);
+		}
+		return sum / blocks.size();
+	}
+};
+
+//tallies kept while scanning one chunk & summed afterwards - no shared counters between workers
+struct ScanCounters {
+	uint64_t words = 0, missing = 0;
+	uint64_t bloomRejects = 0, bloomFalsePositives = 0;	//absent words stopped by / slipping past the filter
+	uint64_t suggestQueries = 0, suggestNanos = 0;
+
+	void add(const ScanCounters& o){
+		words += o.words; missing += o.missing;
+		bloomRejects += o.bloomRejects; bloomFalsePositives += o.bloomFalsePositives;
+		suggestQueries += o.suggestQueries; suggestNanos += o.suggestNanos;
+	}
+};
+
+/* Bit-parallel Levenshtein distance (Myers 1999, in Hyyro's formulation for whole strings)
+	one column of the DP matrix lives in the bits of two words, so each text character costs
+	a handful of ALU ops instead of a row of comparisons; the pattern may be up to 64 bytes	*/
+class Levenshtein {
+private:
+	uint64_t peq[256];	//bit i set in peq[c] when pattern[i] == c
+	size_t m;
+
+public:
+	Levenshtein(string_view pattern) : m(pattern.size()){
+		memset(peq, 0, sizeof(peq));
+		for(size_t i = 0; i < m; i++){peq[static_cast<unsigned char>(pattern[i])] |= 1ull << i;}
+	}
+
+	unsigned distance(string_view text) const{
+		if(m == 0){return text.size();}
+		uint64_t pv = (m == 64) ? ~0ull : (1ull << m) - 1, mv = 0;
+		uint64_t last = 1ull << (m - 1);
+		unsigned score = m;
+		for(unsigned char c : text){
+			uint64_t eq = peq[c];
+			uint64_t xv = eq | mv;
+			uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+			uint64_t ph = mv | ~(xh | pv);
+			uint64_t mh = pv & xh;
+			if(ph & last){score++;}
+			else if(mh & last){score--;}
+			ph = (ph << 1) | 1;	//row 0 of the matrix counts up: D[0][j] = j
+			mh <<= 1;
+			pv = mh | ~(xv | ph);
+			mv = ph & xv;
+		}
+		return score;
+	}
+};
+
+/* Spelling suggestions (--suggest), SymSpell style
+	every dictionary word is filed under each string reachable by deleting up to maxDistance characters
+	from its first prefixLength characters; a query generates the same deletes of its own prefix &
+	only the words filed under them can be within maxDistance - no scan over the dictionary
+	(two strings within distance d share a common string <= d deletes away from each, & this survives
+	cutting both to the same prefix length - so the prefix trick loses no matches)
+	deletes are stored as hashes in a bucketed array (CSR: offsets + entries); an entry packs where the
+	word sits in the text with its length & the set of letters it uses, so words of the wrong length, or
+	with more than maxDistance letters one side lacks, drop out without touching the text - only the
+	survivors are verified against the full word with the bit-parallel distance above
+	the prefix is 9 long: at 7, every word sharing a stem shares its deletes & a one-letter typo of a
+	real word drew ~280 distinct candidates; 9 leaves ~30 after the filters, for twice the memory	*/
+class SuggestionIndex {
+public:
+	struct Suggestion {
+		string_view word;
+		unsigned distance;
+	};
+
+private:
+	string text;						//every word, alphabetical & packed end to end
+	vector<uint32_t> bucketStart;		//entries of bucket b are slots[bucketStart[b] .. bucketStart[b+1])
+	vector<uint64_t> slots;				//entry: word offset in text << 32 | letters << 6 | word length
+	uint64_t mask;
+	unsigned maxDistance;
+	static constexpr size_t prefixLength = 9;
+	static constexpr size_t longestWord = 62;	//6 bits of length; longer words are stored as 63 & never match
+
+	//which letters w uses, one bit each (other bytes share bits - that only weakens the filter)
+	static uint32_t letters(string_view w){
+		uint32_t set = 0;
+		for(unsigned char c : w){set |= 1u << (c % 26);}
+		return set;
+	}
+
+	//h hashes what is kept of s[0 .. from); positions from on may still be deleted, in increasing order
+	//so each set of positions comes up once - & the kept prefix's hash is reused, never recomputed
+	static void deletes(const char* s, size_t len, size_t from, uint64_t h, unsigned left, vector<uint64_t>& out){
+		out.push_back(hashFinish(hashAppend(h, s + from, len - from)));
+		if(left == 0){return;}
+		for(size_t i = from; i < len; i++){
+			deletes(s, len, i + 1, h, left - 1, out);
+			h = hashAppend(h, s + i, 1);
+		}
+	}
+
+	//hashes of every distinct delete of w's prefix
+	void prefixDeletes(string_view w, vector<uint64_t>& out) const{
+		out.clear();
+		deletes(w.data(), min(w.size(), prefixLength), 0, hashSeed, maxDistance, out);
+		sort(out.begin(), out.end());
+		out.erase(unique(out.begin(), out.end()), out.end());
+	}
+
+public:
+	SuggestionIndex() : mask(0), maxDistance(2){}
+
+	void build(const Dictionary& dictionary, unsigned distance = 2){
+		maxDistance = distance;
+		string all;						//backends may hand out temporary views - copy, then sort
+		vector<pair<uint32_t,uint32_t>> spans;
+		spans.reserve(dictionary.size());
+		dictionary.forEachWord([&](string_view w){ spans.emplace_back(all.size(), w.size()); all.append(w); });
+		auto view = [&](const pair<uint32_t,uint32_t>& s){ return string_view(all.data() + s.first, s.second); };
+		sort(spans.begin(), spans.end(), [&](const pair<uint32_t,uint32_t>& a, const pair<uint32_t,uint32_t>& b){ return view(a) < view(b); });
+		text.clear();
+		vector<uint64_t> entry;			//offsets grow with the text, so entries sort alphabetically
+		entry.reserve(spans.size());
+		for(const pair<uint32_t,uint32_t>& s : spans){
+			entry.push_back(uint64_t(text.size()) << 32 | uint64_t(letters(view(s))) << 6 | min<size_t>(s.second, longestWord + 1));
+			text.append(view(s));
+		}
+		auto word = [&](size_t i){ return view(spans[i]); };
+
+		vector<uint64_t> hashes;
+		uint64_t entries = 0;	//pass 1: size the table
+		for(size_t i = 0; i < spans.size(); i++){ prefixDeletes(word(i), hashes); entries += hashes.size(); }
+		uint64_t buckets = 1;
+		while(2 * buckets < entries){buckets *= 2;}
+		mask = buckets - 1;
+
+		bucketStart.assign(buckets + 1, 0);	//pass 2: count per bucket, then prefix-sum into offsets
+		for(size_t i = 0; i < spans.size(); i++){
+			prefixDeletes(word(i), hashes);
+			for(uint64_t h : hashes){bucketStart[(h & mask) + 1]++;}
+		}
+		for(uint64_t b = 0; b < buckets; b++){bucketStart[b + 1] += bucketStart[b];}
+
+		slots.resize(entries);				//pass 3: fill
+		vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+		for(size_t i = 0; i < spans.size(); i++){
+			prefixDeletes(word(i), hashes);
+			for(uint64_t h : hashes){slots[fill[h & mask]++] = entry[i];}
+		}
+	}
+
+	bool isBuilt() const{ return !slots.empty(); }
+	uint64_t entries() const{ return slots.size(); }
+	uint64_t memoryBytes() const{
+		return text.size() + bucketStart.size() * sizeof(uint32_t) + slots.size() * sizeof(uint64_t);
+	}
+
+	//up to limit dictionary words within maxDistance of q, closest first (ties alphabetical)
+	//the tables are far bigger than cache, so each phase first prefetches everything it will touch:
+	//the misses then overlap instead of being paid one after another
+	void suggest(string_view q, size_t limit, vector<Suggestion>& out) const{
+		out.clear();
+		if(q.size() + maxDistance > longestWord){return;}	//longer than any word worth suggesting
+		thread_local vector<uint64_t> hashes;
+		thread_local vector<uint64_t> candidates;
+		prefixDeletes(q, hashes);
+		for(uint64_t h : hashes){__builtin_prefetch(&bucketStart[h & mask]);}
+		for(uint64_t h : hashes){__builtin_prefetch(&slots[bucketStart[h & mask]]);}
+
+		size_t lo = q.size() > maxDistance ? q.size() - maxDistance : 0, hi = q.size() + maxDistance;
+		uint32_t used = letters(q);
+		candidates.clear();
+		for(uint64_t h : hashes){	//each edit adds or drops at most one character & one letter: most entries fail on that alone
+			uint64_t b = h & mask;
+			for(uint32_t i = bucketStart[b]; i < bucketStart[b + 1]; i++){
+				uint64_t e = slots[i];
+				size_t len = e & 63;
+				uint32_t set = (e >> 6) & ((1u << 26) - 1);
+				if(len < lo || len > hi){continue;}
+				if(unsigned(__builtin_popcount(set & ~used)) > maxDistance || unsigned(__builtin_popcount(used & ~set)) > maxDistance){continue;}
+				candidates.push_back(e);
+			}
+		}
+		sort(candidates.begin(), candidates.end());	//by offset: results come out in word order
+		candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+		for(uint64_t e : candidates){__builtin_prefetch(text.data() + (e >> 32));}
+
+		Levenshtein kernel(q);
+		for(uint64_t e : candidates){
+			string_view w(text.data() + (e >> 32), e & 63);
+			unsigned d = kernel.distance(w);
+			if(d <= maxDistance){out.push_back(Suggestion{w, d});}
+		}
+		stable_sort(out.begin(), out.end(), [](const Suggestion& a, const Suggestion& b){ return a.distance < b.distance; });
+		if(out.size() > limit){out.resize(limit);}
+	}
+};
+
+//what a scan checks words against; only the dictionary is required
+struct ScanContext {
+	const Dictionary* dictionary;
+	const BloomFilter* bloom;				//optional pre-check (--bloom)
+	const SuggestionIndex* suggestions;		//optional suggestions for missing words (--suggest)
+};
+const size_t suggestionsPerWord = 3;
+
+//one dictionary query: hash once, ask the Bloom filter (if any), then the table
+inline bool lookupWord(const ScanContext& ctx, string_view w, ScanCounters& c){
+	uint64_t h = hashWord(w);
+	if(ctx.bloom && !ctx.bloom->mayContain(h)){ c.bloomRejects++; return false; }
+	if(ctx.dictionary->contains(w, h)){return true;}
+	if(ctx.bloom){c.bloomFalsePositives++;}
+	return false;
+}
+
+//append the suggestions for a missing word to out: lead, then the words joined by separator
+void appendSuggestions(const ScanContext& ctx, string_view word, string& out, const char* lead, const char* separator, ScanCounters& c){
+	thread_local vector<SuggestionIndex::Suggestion> found;
+	chrono::steady_clock::time_point a = chrono::steady_clock::now();
+	ctx.suggestions->suggest(word, suggestionsPerWord, found);
+	c.suggestNanos += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - a).count();
+	c.suggestQueries++;
+	for(size_t i = 0; i < found.size(); i++){
+		out += i ? separator : lead;
+		out += found[i].word;
+	}
+}
+
+/* Counts of distinct words (--top K)
+	open addressing with linear probing; each entry is 24 bytes & the words themselves are
+	copied once into a single arena string, so a word seen a million times costs one entry
+	one counter per worker, merged at the end - workers never share a counter	*/
+class WordCounter {
+public:
+	struct Entry {
+		uint64_t hash;
+		uint32_t offset, length;	//word position in the arena
+		uint64_t count;				//0 marks an empty entry
+	};
+
+private:
+	vector<Entry> entries;
+	string arena;
+	uint64_t distinct;
+
+	void grow(){
+		vector<Entry> old(entries.size() ? 2 * entries.size() : 1024, Entry{0, 0, 0, 0});
+		old.swap(entries);
+		uint64_t mask = entries.size() - 1;
+		for(const Entry& e : old){
+			if(!e.count){continue;}
+			uint64_t i = e.hash & mask;
+			while(entries[i].count){i = (i + 1) & mask;}
+			entries[i] = e;
+		}
+	}
+
+public:
+	WordCounter() : distinct(0){ grow(); }
+
+	void add(string_view w, uint64_t h, uint64_t n = 1){
+		if(4 * (distinct + 1) > 3 * entries.size()){grow();}	//keep load <= 3/4
+		uint64_t mask = entries.size() - 1;
+		uint64_t i = h & mask;
+		for(; entries[i].count; i = (i + 1) & mask){
+			Entry& e = entries[i];
+			if(e.hash == h && string_view(arena.data() + e.offset, e.length) == w){ e.count += n; return; }
+		}
+		entries[i] = Entry{h, static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(w.size()), n};
+		arena.append(w);
+		distinct++;
+	}
+	void add(string_view w){ add(w, hashWord(w)); }
+
+	void merge(const WordCounter& o){
+		for(const Entry& e : o.entries){
+			if(e.count){add(string_view(o.arena.data() + e.offset, e.length), e.hash, e.count);}
+		}
+	}
+
+	uint64_t size() const{ return distinct; }
+	uint64_t total() const{
+		uint64_t t = 0;
+		for(const Entry& e : entries){t += e.count;}
+		return t;
+	}
+
+	//the k most frequent words, most frequent first; ties go alphabetically so the report is deterministic
+	//partial_sort only orders the k winners - O(n log k), not a full sort
+	vector<pair<string_view,uint64_t>> top(size_t k) const{
+		vector<pair<string_view,uint64_t>> all;
+		all.reserve(distinct);
+		for(const Entry& e : entries){
+			if(e.count){all.emplace_back(string_view(arena.data() + e.offset, e.length), e.count);}
+		}
+		k = min(k, all.size());
+		partial_sort(all.begin(), all.begin() + k, all.end(), [](const pair<string_view,uint64_t>& a, const pair<string_view,uint64_t>& b){
+			return a.second != b.second ? a.second > b.second : a.first < b.first;
+		});
+		all.resize(k);
+		return all;
+	}
+};
+
+//a contiguous piece of one mapped book; large books are cut into several so one file can use every core
+struct BookChunk {
+	char* begin;
+	char* end;
+};
+const size_t chunkBytes = 4 << 20;	//big enough to amortize task overhead, small enough to balance
+
+//cut a book's text into chunks of about chunkBytes, only ever splitting between words
+//so no word straddles two chunks; the text stays writable, as the scan lowercases it in place
+void splitBook(char* text, size_t length, vector<BookChunk>& chunks){
+	char* cur = text;
+	char* end = cur + length;
+	while(cur < end){
+		char* cut = (size_t(end - cur) > chunkBytes) ? cur + chunkBytes : end;
+		while(cut < end && isWordByte(*cut)){cut++;}
+		chunks.push_back(BookChunk{cur, cut});
+		cur = cut;
+	}
+}
+
+//check every word of a chunk; missing words are formatted into out, or counted in tally if given
+void scanChunk(const ScanContext& ctx, const BookChunk& chunk, string& out, ScanCounters& c, WordCounter* tally){
+	tokenize(chunk.begin, chunk.end, [&](string_view word){
+		c.words++;
+		if(!lookupWord(ctx, word, c)){
+			c.missing++;
+			if(tally){ tally->add(word); return; }
+			out += "\t    ";
+			out += word;
+			if(ctx.suggestions){appendSuggestions(ctx, word, out, "  ->  ", ", ", c);}
+			out += '\n';
+		}
+	});
+}
+
+//scan chunks on a pool of threads; each worker claims the next unscanned chunk, so the load balances itself
+//chunk results are released to emit() strictly in chunk order as soon as they (and all before them) are done
+//returns the counters of all chunks
+//with tallies, missing words are counted instead of emitted: worker t owns (*tallies)[t], sized to threads
+template<typename F>
+ScanCounters scanBooks(const ScanContext& ctx, const vector<BookChunk>& chunks, unsigned threads,
+	F emit, vector<WordCounter>* tallies = nullptr){
+	vector<string> results(chunks.size());
+	vector<ScanCounters> counters(chunks.size());
+	vector<char> done(chunks.size(), 0);
+	mutex m;
+	condition_variable ready;
+	atomic<size_t> next(0);
+
+	auto worker = [&](unsigned t){
+		WordCounter* tally = tallies ? &(*tallies)[t] : nullptr;
+		for(size_t i; (i = next.fetch_add(1)) < chunks.size();){
+			string out;
+			ScanCounters c;
+			scanChunk(ctx, chunks[i], out, c, tally);
+			lock_guard<mutex> lock(m);
+			results[i] = move(out);
+			counters[i] = c;
+			done[i] = 1;
+			ready.notify_one();
+		}
+	};
+	vector<thread> pool;
+	for(unsigned t = 0; t < threads; t++){pool.emplace_back(worker, t);}
+
+	ScanCounters total;
+	for(size_t i = 0; i < chunks.size(); i++){	//deterministic merge: argument order, then chunk order
+		string out;
+		{
+			unique_lock<mutex> lock(m);
+			ready.wait(lock, [&]{ return done[i] != 0; });
+			out = move(results[i]);
+			total.add(counters[i]);
+		}
+		emit(out);
+	}
+	for(thread& t : pool){t.join();}
+	return total;
+}
+
+//which backend to load, & what to build beside it
+struct BackendOptions {
+	bool useIndex, useDawg, useBloom, suggest;
+};
+
+//one complete, immutable dictionary: the backend in use plus its Bloom filter & suggestion index
+//everything a scan needs lives here, so a reload can build a whole new one & swap it in at once
+struct LoadedDictionary {
+	unique_ptr<MappedFile> text;		//mapped dict.txt - table keys point into it
+	FlatWordSet table;
+	Dawg dawg;
+	unique_ptr<DictionaryIndex> index;	//--index
+	unique_ptr<DawgFile> dawgFile;		//--dawg --index
+	BloomFilter bloom;
+	SuggestionIndex suggestions;
+	ScanContext ctx{};
+	SourceStamp stamp{};				//dict.txt as it was when loading began
+	double loadMs = 0, suggestBuildMs = 0;
+
+	const FlatWordSet* hashTable() const{ return index ? &index->words() : (ctx.dictionary == &table ? &table : nullptr); }
+	const Dawg* automaton() const{ return dawgFile ? &dawgFile->words() : (ctx.dictionary == &dawg ? &dawg : nullptr); }
+};
+
+//load source with the chosen backend; on failure returns nullptr & says why in error
+unique_ptr<LoadedDictionary> loadBackend(const char* source, const BackendOptions& options, string& error){
+	unique_ptr<LoadedDictionary> d(new LoadedDictionary);
+	chrono::steady_clock::time_point a = chrono::steady_clock::now();
+	SourceStamp::of(source, d->stamp);
+	if(options.useDawg && options.useIndex){
+		d->dawgFile = openCompiled<DawgFile>(source, "dict.dawg", compileDawg);
+		if(!d->dawgFile){ error = "Unable to open or compile dict.dawg"; return nullptr; }
+		d->ctx.dictionary = &d->dawgFile->words();
+	}
+	else if(options.useIndex){
+		d->index = openCompiled<DictionaryIndex>(source, "dict.idx", compileIndex);
+		if(!d->index){ error = "Unable to open or compile dict.idx"; return nullptr; }
+		d->ctx.dictionary = &d->index->words();
+	}
+	else{
+		d->text.reset(new MappedFile(source));
+		if(!d->text->isOpen()){ error = string("Unable to open ") + source; return nullptr; }
+		if(options.useDawg){
+			if(!d->dawg.build(sortedWords(*d->text))){ error = string(source) + " is too large for the DAWG backend"; return nullptr; }
+			d->text.reset();	//the automaton keeps its own labels
+			d->ctx.dictionary = &d->dawg;
+		}
+		else{
+			loadDictionary(*d->text, d->table);	//Dictionary supplied by ethan is line-delineated
+			d->ctx.dictionary = &d->table;
+		}
+	}
+	d->loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - a).count();
+	if(options.useBloom){
+		d->bloom.build(*d->ctx.dictionary);
+		d->ctx.bloom = &d->bloom;
+	}
+	if(options.suggest){
+		a = chrono::steady_clock::now();
+		d->suggestions.build(*d->ctx.dictionary);
+		d->suggestBuildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - a).count();
+		d->ctx.suggestions = &d->suggestions;
+	}
+	return d;
+}
+
+/* Hot-reloadable dictionary (--watch)
+	the version in use is one atomic pointer; a reload builds a complete new LoadedDictionary off
+	to the side, then swaps the pointer, so readers see the old dictionary or the new one - never a mix
+	readers never lock: a Pin records the epoch it started in, then reads the pointer
+	epoch-based reclamation: a replaced version is retired with the epoch of its swap & freed only
+	once every pin is either gone or began after that swap (& so holds the new version)
+	a watcher thread polls dict.txt's size & mtime & reloads once a change has settled for one poll
+	dict.txt should be replaced by rename (as mv & most editors do): the hash backend keeps keys in
+	the mapped file, & a file truncated in place under a live mapping faults	*/
+class LiveDictionary {
+private:
+	struct alignas(64) ReaderSlot { atomic<uint64_t> epoch{0}; };	//0: free; own cache line, so pins don't false-share
+	static const unsigned readerSlots = 64;
+
+	atomic<LoadedDictionary*> current;
+	atomic<uint64_t> epoch{1};
+	ReaderSlot readers[readerSlots];
+	vector<pair<LoadedDictionary*, uint64_t>> retired;	//version & the epoch its swap began; writer only
+	atomic<uint64_t> reloadCount{0};
+
+	thread watcher;
+	mutex m;
+	condition_variable wake;
+	bool stopping = false;
+
+	//free the retired versions no pin can still be reading
+	void reclaim(){
+		uint64_t oldest = UINT64_MAX;	//earliest epoch any pin began in
+		for(const ReaderSlot& r : readers){
+			uint64_t e = r.epoch.load();
+			if(e){oldest = min(oldest, e);}
+		}
+		size_t kept = 0;
+		for(pair<LoadedDictionary*, uint64_t>& v : retired){
+			if(v.second <= oldest){delete v.first;}
+			else{retired[kept++] = v;}
+		}
+		retired.resize(kept);
+	}
+
+	void watch(string source, BackendOptions options, chrono::milliseconds interval){
+		SourceStamp loaded = current.load()->stamp, previous = loaded;
+		unique_lock<mutex> lock(m);
+		while(!wake.wait_for(lock, interval, [&]{ return stopping; })){
+			SourceStamp now{};
+			bool changed = SourceStamp::of(source.c_str(), now) && !now.sameAs(loaded);
+			bool settled = now.sameAs(previous);	//unchanged since the last poll - not mid-write
+			previous = now;
+			if(changed && settled){
+				lock.unlock();	//loading can take a while; stop() must not wait on it
+				string error;
+				unique_ptr<LoadedDictionary> next = loadBackend(source.c_str(), options, error);
+				if(next){
+					uint64_t words = next->ctx.dictionary->size();
+					publish(move(next));
+					cerr << "dictionary-lookup: reloaded " << source << " (" << words << " words)\n";
+				}
+				else{cerr << "dictionary-lookup: reload failed, keeping the current dictionary: " << error << "\n";}
+				loaded = now;	//a failed file is not retried until it changes again
+				lock.lock();
+			}
+			reclaim();
+		}
+	}
+
+public:
+	//a reader's hold on the current version; cheap enough to take once per buffer
+	class Pin {
+	private:
+		ReaderSlot* slot;
+		const LoadedDictionary* version;
+
+	public:
+		Pin(LiveDictionary& live) : slot(nullptr){
+			for(unsigned i = 0; !slot; i = (i + 1) % readerSlots){	//claim a free slot (spins only if all are taken)
+				uint64_t free = 0;
+				if(live.readers[i].epoch.compare_exchange_strong(free, live.epoch.load())){slot = &live.readers[i];}
+				else if(i == readerSlots - 1){this_thread::yield();}
+			}
+			version = live.current.load();	//read after the slot is claimed: the writer sees the pin or we see its swap
+		}
+		~Pin(){ slot->epoch.store(0); }
+		Pin(const Pin&) = delete;
+		Pin& operator =(const Pin&) = delete;
+
+		const LoadedDictionary& operator *() const{ return *version; }
+		const LoadedDictionary* operator ->() const{ return version; }
+	};
+
+	LiveDictionary(unique_ptr<LoadedDictionary> initial) : current(initial.release()){}
+	~LiveDictionary(){
+		stop();
+		for(pair<LoadedDictionary*, uint64_t>& v : retired){delete v.first;}	//no pins outlive the object
+		delete current.load();
+	}
+	LiveDictionary(const LiveDictionary&) = delete;
+	LiveDictionary& operator =(const LiveDictionary&) = delete;
+
+	//swap in a new version; the old one is freed once no pin can still hold it
+	//one writer at a time: the watcher, or the owner before watching starts
+	void publish(unique_ptr<LoadedDictionary> next){
+		LoadedDictionary* old = current.exchange(next.release());
+		retired.emplace_back(old, epoch.fetch_add(1) + 1);	//pins from this epoch on were taken after the swap
+		reloadCount++;
+		reclaim();
+	}
+
+	//reload source in the background whenever it changes
+	void startWatching(const char* source, const BackendOptions& options, chrono::milliseconds interval){
+		watcher = thread(&LiveDictionary::watch, this, string(source), options, interval);
+	}
+	void stop(){
+		if(!watcher.joinable()){return;}
+		{ lock_guard<mutex> lock(m); stopping = true; }
+		wake.notify_one();
+		watcher.join();
+	}
+
+	uint64_t reloads() const{ return reloadCount.load(); }
+};
+const chrono::milliseconds watchInterval(500);
+
+/* Streaming mode (--stdin)
+	reads fd through one fixed-size buffer, so memory stays bounded whatever the input size
+	a word cut off by the end of a read is carried to the front of the buffer & finished by the next read
+	missing words go to out as plain lines, written once per buffer - or are counted in tally if given
+	suggestions, if any, follow their word on the same line: word<TAB>first,second,third
+	each buffer is checked against one pinned dictionary version, so a reload lands between buffers	*/
+const size_t streamBufferBytes = 1 << 20;
+
+int streamWords(LiveDictionary& live, int fd, FILE* out, WordCounter* tally = nullptr){
+	vector<char> buffer(streamBufferBytes);
+	size_t carry = 0;	//bytes of an unfinished word at the front of the buffer
+	string missing;
+	ScanCounters c;
+	const ScanContext* ctx = nullptr;
+	auto check = [&](string_view word){
+		if(!lookupWord(*ctx, word, c)){
+			if(tally){ tally->add(word); return; }
+			missing += word;
+			if(ctx->suggestions){appendSuggestions(*ctx, word, missing, "\t", ",", c);}
+			missing += '\n';
+		}
+	};
+	while(true){
+		ssize_t n = read(fd, buffer.data() + carry, buffer.size() - carry);
+		if(n < 0 && errno == EINTR){continue;}
+		if(n < 0){return 1;}
+		char* begin = buffer.data();
+		char* end = begin + carry + n;
+		char* cut = end;
+		if(n > 0){	//hold back a trailing partial word - unless it fills the whole buffer
+			while(cut > begin && isWordByte(cut[-1])){cut--;}
+			if(cut == begin){
+				if(end < begin + buffer.size()){ carry = end - begin; continue; }	//short read (pipes): keep filling
+				cut = end;
+			}
+		}
+		{
+			LiveDictionary::Pin version(live);	//not held across read(): an idle pipe never delays reclamation
+			ctx = &version->ctx;
+			tokenize(begin, cut, check);
+		}
+		if(!missing.empty()){
+			fwrite(missing.data(), 1, missing.size(), out);
+			missing.clear();
+		}
+		if(n == 0){break;}	//end of input
+		carry = end - cut;
+		memmove(begin, cut, carry);
+	}
+	return fflush(out) == 0 ? 0 : 1;
+}
+
+/* Benchmark (--bench)
+	generates a synthetic corpus in memory: dictionary words in mixed case with a chosen share of
+	non-words, separated by a mix of spaces, newlines & punctuation - deterministic for a given seed
+	then times each phase separately, best of `repeat` runs each:
+		load		building or mapping the dictionary (timed by main)
+		tokenize	splitting & lowercasing the corpus
+		lookup		checking pre-split words against the dictionary
+		scan		both together on the worker pool, as a real run does
+	results are one JSON object on stdout, so runs can be collected & compared; "index" is true when the
+	backend was mapped from its precompiled file (--index) rather than built from dict.txt	*/
+struct BenchConfig {
+	uint64_t words = 5000000;
+	double missRatio = 0.1;
+	unsigned repeat = 3;
+	uint64_t seed = 1;
+};
+
+//peak resident set size of this process so far, in KiB
+long peakRssKiB(){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+string syntheticCorpus(const Dictionary& dictionary, const BenchConfig& cfg){
+	string pool;					//every dictionary word, to draw from
+	vector<uint32_t> starts(1, 0);
+	dictionary.forEachWord([&](string_view w){ pool.append(w); starts.push_back(pool.size()); });
+
+	mt19937_64 rng(cfg.seed);
+	uniform_real_distribution<double> unit(0, 1);
+	const char* separators[] = {" ", " ", " ", " ", "\n", ", ", ". ", "\t", "; ", "! "};
+	string corpus, miss;
+	for(uint64_t i = 0; i < cfg.words; i++){
+		if(unit(rng) < cfg.missRatio){	//a random letter string that is really absent
+			do{
+				miss.assign(4 + rng() % 9, 'a');
+				for(char& c : miss){c = 'a' + rng() % 26;}
+			}while(dictionary.contains(miss));
+			corpus += miss;
+		}
+		else{
+			uint64_t k = rng() % (starts.size() - 1);
+			size_t at = corpus.size();
+			corpus.append(pool, starts[k], starts[k + 1] - starts[k]);
+			if(rng() % 8 == 0){corpus[at] -= 'a' - 'A';}	//capitalized now & then, for the tokenizer to fold
+		}
+		corpus += separators[rng() % 10];
+	}
+	return corpus;
+}
+
+int runBenchmark(const ScanContext& ctx, const BenchConfig& cfg, unsigned threads, const char* backend, bool mapped, double loadMs, double loadFactor){
+	string corpus = syntheticCorpus(*ctx.dictionary, cfg);
+	string work;
+	typedef chrono::steady_clock clock;
+	auto seconds = [](clock::time_point a, clock::time_point b){ return chrono::duration<double>(b - a).count(); };
+	double tokenizeSec = 1e300, lookupSec = 1e300, scanSec = 1e300;
+	uint64_t tokens = 0, misses = 0;
+
+	for(unsigned r = 0; r < cfg.repeat; r++){	//tokenize only
+		work = corpus;
+		tokens = 0;
+		clock::time_point a = clock::now();
+		tokenize(&work[0], &work[0] + work.size(), [&](string_view){ tokens++; });
+		tokenizeSec = min(tokenizeSec, seconds(a, clock::now()));
+	}
+
+	vector<string_view> split;	//lookup only, over words split beforehand
+	split.reserve(tokens);
+	work = corpus;
+	tokenize(&work[0], &work[0] + work.size(), [&](string_view w){ split.push_back(w); });
+	for(unsigned r = 0; r < cfg.repeat; r++){
+		ScanCounters c;
+		misses = 0;
+		clock::time_point a = clock::now();
+		for(string_view w : split){ if(!lookupWord(ctx, w, c)){misses++;} }
+		lookupSec = min(lookupSec, seconds(a, clock::now()));
+	}
+
+	for(unsigned r = 0; r < cfg.repeat; r++){	//end to end on the worker pool, output discarded
+		work = corpus;
+		vector<BookChunk> chunks;
+		splitBook(&work[0], work.size(), chunks);
+		clock::time_point a = clock::now();
+		scanBooks(ctx, chunks, threads, [](const string&){});
+		scanSec = min(scanSec, seconds(a, clock::now()));
+	}
+
+	printf("{\"backend\": \"%s\", \"index\": %s, \"bloom\": %s, \"threads\": %u, \"dictionary_words\": %llu, \"dictionary_bytes\": %llu, ",
+		backend, mapped ? "true" : "false", ctx.bloom ? "true" : "false", threads, (unsigned long long)ctx.dictionary->size(), (unsigned long long)ctx.dictionary->memoryBytes());
+	if(loadFactor >= 0){printf("\"load_factor\": %.4f, ", loadFactor);}
+	else{printf("\"load_factor\": null, ");}
+	printf("\"corpus_words\": %llu, \"corpus_bytes\": %zu, \"miss_ratio\": %.4f, ", (unsigned long long)tokens, corpus.size(), cfg.missRatio);
+	if(tokens){printf("\"measured_miss_ratio\": %.4f, ", double(misses) / tokens);}
+	else{printf("\"measured_miss_ratio\": null, ");}
+	printf("\"load_ms\": %.3f, ", loadMs);
+	auto perWord = [&](const char* phase, double sec){	//no words (--bench-words 0): nothing to divide by, so null
+		if(tokens){printf("\"%s_ns_per_word\": %.2f, \"%s_words_per_sec\": %.0f, ", phase, 1e9 * sec / tokens, phase, tokens / sec);}
+		else{printf("\"%s_ns_per_word\": null, \"%s_words_per_sec\": null, ", phase, phase);}
+	};
+	perWord("tokenize", tokenizeSec);
+	perWord("lookup", lookupSec);
+	perWord("scan", scanSec);
+	printf("\"peak_rss_kib\": %ld}\n", peakRssKiB());
+	return 0;
+}
+
 int main(int argc, char *argv[]){
+	//////////////////////////////////////////////////////////////////////////////// Variable declarations
+	unique_ptr<LoadedDictionary> loaded;	//declare dictionary list: backend, Bloom filter & suggestion index
+	bool useIndex = false, compileOnly = false, showStats = false, useBloom = false, streamMode = false, suggest = false, useDawg = false;
+	bool watch = false;					//--watch: reload dict.txt when it changes (--stdin)
+	const char* prefix = nullptr;		//--prefix: list words instead of checking books
+	bool benchMode = false;
+	BenchConfig bench;
+	vector<const char*> books;
+	unsigned threads = thread::hardware_concurrency();
+	size_t topK = 0;					//0: list every missing occurrence
+
+	for(int i = 1; i < argc; i++){	//split options from book file arguments
+		string arg = argv[i];
+		if(arg == "--index"){useIndex = true;}
+		else if(arg == "--threads" && i + 1 < argc){threads = atoi(argv[++i]);}
+		else if(arg == "--compile"){compileOnly = true;}
+		else if(arg == "--stats"){showStats = true;}
+		else if(arg == "--bloom"){useBloom = true;}
+		else if(arg == "--stdin"){streamMode = true;}
+		else if(arg == "--watch"){watch = true;}
+		else if(arg == "--suggest"){suggest = true;}
+		else if(arg == "--dawg"){useDawg = true;}
+		else if(arg == "--prefix" && i + 1 < argc){ prefix = argv[++i]; useDawg = true; }	//only the automaton can enumerate
+		else if(arg == "--top" && i + 1 < argc){topK = strtoull(argv[++i], nullptr, 10);}
+		else if(arg == "--bench"){benchMode = true;}
+		else if(arg == "--bench-words" && i + 1 < argc){bench.words = strtoull(argv[++i], nullptr, 10);}
+		else if(arg == "--miss-ratio" && i + 1 < argc){bench.missRatio = atof(argv[++i]);}
+		else if(arg == "--repeat" && i + 1 < argc){bench.repeat = max(1, atoi(argv[++i]));}
+		else if(arg == "--seed" && i + 1 < argc){bench.seed = strtoull(argv[++i], nullptr, 10);}
+		else{books.push_back(argv[i]);}
+	}
+	//pipe & benchmark modes keep stdout for their output alone; problems go to stderr
+	bool quiet = streamMode || benchMode;
+	auto fail = [&](const char* message){
+		if(quiet){ cerr << "dictionary-lookup: " << message << "\n"; return 1; }
+		cout << "\t" << message << "\n";
+		return endProgram(1);
+	};
+
 	//////////////////////////////////////////////////////////////////////////////   Pretty Header
-	textcolor('g');
-	cout << "\n\n_________________________________________________________________________________\n\n";
-	cout << "An Implementation of the C++ Unordered Map Library\n";
-	cout << "Written by Stephen Opet III\n";
-	cout << "https://github.com/stephen-opet\n\n\n";
-	textcolor('w');
+	if(!quiet){	//pipe & benchmark modes: no banner, no colors
+		textcolor('g');
+		cout << "\n\n_________________________________________________________________________________\n\n";
+		cout << "An Implementation of the C++ Unordered Map Library\n";
+		cout << "Written by Stephen Opet III\n";
+		cout << "https://github.com/stephen-opet\n\n\n";
+		textcolor('w');
+	}
 
-	//////////////////////////////////////////////////////////////////////////////// Variable declarations
-	unordered_map<string,uint64_t> dictionary;	//declare dictionary list
-	ifstream f("dict.txt");		//open dictionary file
-	string line = ""; 			//containter for lines from files
-	uint64_t key = 1; 			//iterative key for map
+	///////////////////////////////////////////////////////////////////////////////  Compile dict.txt into dict.idx & dict.dawg
+	if(compileOnly){
+		if(!compileIndex("dict.txt", "dict.idx")){return fail("Unable to compile dict.txt into dict.idx");}
+		if(!compileDawg("dict.txt", "dict.dawg")){return fail("Unable to compile dict.txt into dict.dawg");}
+		cout << "\tCompiled dict.txt into dict.idx & dict.dawg\n";
+		return endProgram(0);
+	}
 
 	///////////////////////////////////////////////////////////////////////////////  Build dictionary from dict.txt
-	while(true){				
-		getline(f, line); 		//Dictionary supplied by ethan is line-delineated
-		if(line.length() == 0){break;}	//Abort if we reach an empty line
-		else{
-			dictionary[line] = key++;	//add key-value pairs to dictionary
-			if(f.eof()){break;}			//Abort at end of file
+	BackendOptions options{useIndex, useDawg, useBloom && !prefix, suggest && !prefix};
+	string error;
+	loaded = loadBackend("dict.txt", options, error);
+	if(!loaded){return fail(error.c_str());}
+	const Dictionary* lookup = loaded->ctx.dictionary;	//whichever backend is in use
+	uint64_t words = lookup->size();
+	if(threads == 0){threads = 1;}	//hardware_concurrency() may not know
+
+	///////////////////////////////////////////////////////////////////////////////  List words by prefix
+	if(prefix){
+		uint64_t listed = 0;
+		cout << "\tDictionary words starting with \"" << prefix << "\":\n";
+		loaded->automaton()->forEachWithPrefix(prefix, [&](string_view w){ cout << "\t    " << w << "\n"; listed++; });
+		cout << "\t(" << listed << " words)\n";
+		return endProgram(0);
+	}
+
+	const ScanContext& ctx = loaded->ctx;
+	ScanCounters reportCounters;	//suggestions made for the --top report
+
+	///////////////////////////////////////////////////////////////////////////////	 Benchmark on a synthetic corpus
+	if(benchMode){
+		double loadFactor = useDawg ? -1 : loaded->hashTable()->loadFactor();
+		return runBenchmark(ctx, bench, threads, useDawg ? "dawg" : "hash", useIndex, loaded->loadMs, loadFactor);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////	 Stream standard input (pipe mode)
+	if(streamMode){
+		LiveDictionary live(move(loaded));
+		if(watch){live.startWatching("dict.txt", options, watchInterval);}
+		WordCounter tally;
+		if(streamWords(live, STDIN_FILENO, stdout, topK ? &tally : nullptr) != 0){
+			return fail("Error streaming standard input");
 		}
+		live.stop();
+		LiveDictionary::Pin version(live);	//suggest from the dictionary as it is now
+		for(const pair<string_view,uint64_t>& w : tally.top(topK)){
+			string line = to_string(w.second) + "\t" + string(w.first);
+			if(suggest){appendSuggestions(version->ctx, w.first, line, "\t", ",", reportCounters);}
+			printf("%s\n", line.c_str());
+		}
+		return 0;
+	}
+
+	cout << "\tYour Dictionary Contains " << words << " words\n\n";
+	if(showStats && useDawg){
+		const Dawg& automaton = *loaded->automaton();
+		cout << "\tAutomaton: " << automaton.nodeCount() << " nodes, " << automaton.edgeTotal() << " edges, "
+			<< automaton.memoryBytes() / 1024 << " KiB\n\n";
+	}
+	else if(showStats){
+		const FlatWordSet& table = *loaded->hashTable();
+		FlatWordSet::ProbeStats probes = table.probeStats();
+		cout << "\tTable: " << table.slotCount() << " slots, " << table.memoryBytes() / 1024 << " KiB, load factor " << table.loadFactor() << "\n";
+		cout << "\tProbes per lookup: " << probes.averageHit << " (hit), " << probes.averageMiss << " (miss), "
+			<< probes.longestHit << " (longest hit)\n\n";
+	}
+	if(useBloom){
+		cout << "\tBloom filter: " << loaded->bloom.memoryBytes() / 1024 << " KiB, estimated false-positive rate "
+			<< 100 * loaded->bloom.estimatedFalsePositiveRate() << "%\n\n";
+	}
+	if(suggest){
+		cout << "\tSuggestion index: " << loaded->suggestions.entries() << " deletes, " << loaded->suggestions.memoryBytes() / 1024 << " KiB, built in "
+			<< loaded->suggestBuildMs << "ms\n\n";
 	}
-	f.close();	//close the file - allows reuse of "f" for book files 
-	cout << "\tYour Dictionary Contains " << key-1 << " words\n\n";
 
 	///////////////////////////////////////////////////////////////////////////////	 Iterate through book files via CMD args
 	cout << "\tBook words absent from the dictionary:\n";
-	for(int i = 1; i < argc; i++){	//iterate through book file arguments
-		ifstream f(argv[i]);		//open current book file
-		while(true){				//loop through argument file
-			getline(f,line, ' ');	//space-delineated books
-			if(line.length()==0){break;}	//Abort if we reach an empty line
-			else{
-				//GDB reveals dictionary appended escape character \r to values - weird but manageable here
-				if(dictionary.find(line) == dictionary.end() && dictionary.find(line + "\r") == dictionary.end())							
-					cout << "\t    " << line << "\n";					
-			}
-			if(f.eof()){break;}	//abort at last value 
-		}/* End of book file */	f.close();		
+	vector<unique_ptr<MappedFile>> mapped;	//every book stays mapped until its chunks are scanned
+	vector<BookChunk> chunks;
+	for(const char* book : books){	//iterate through book file arguments
+		mapped.emplace_back(new MappedFile(book, true));	//writable: the tokenizer lowercases in place
+		if(mapped.back()->isOpen()){splitBook(mapped.back()->data(), mapped.back()->size(), chunks);}	//unreadable & empty books hold no words
+	}
+	vector<WordCounter> tallies(topK ? threads : 0);	//one per worker
+	ScanCounters c = scanBooks(ctx, chunks, threads, [](const string& out){ cout << out; },
+		topK ? &tallies : nullptr);
+
+	if(topK){	//merge per-worker counts, then report the most frequent
+		WordCounter& all = tallies[0];
+		for(unsigned t = 1; t < threads; t++){all.merge(tallies[t]);}
+		cout << "\t    (" << all.size() << " distinct words, " << all.total() << " occurrences; most frequent " << min<uint64_t>(topK, all.size()) << ")\n";
+		for(const pair<string_view,uint64_t>& w : all.top(topK)){
+			string line = "\t    " + to_string(w.second) + "\t" + string(w.first);
+			if(suggest){appendSuggestions(ctx, w.first, line, "  ->  ", ", ", reportCounters);}
+			cout << line << "\n";
+		}
+	}
+	c.add(reportCounters);
+
+	if(useBloom && c.missing){	//measured on this run's absent words
+		cout << "\n\tBloom filter rejected " << c.bloomRejects << " of " << c.missing << " absent words; measured false-positive rate "
+			<< 100.0 * c.bloomFalsePositives / c.missing << "%\n";
+	}
+	if(suggest && c.suggestQueries){
+		cout << "\n\tSuggestions: " << c.suggestQueries << " queries, " << c.suggestNanos / c.suggestQueries << "ns per query\n";
 	}
 	endProgram(0);
 }
\ No newline at end of file
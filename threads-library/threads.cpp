@@ -4,19 +4,77 @@
 	Published May 24, 2020 [in SARS-COV-2 quarentine :) ]
 
 	At its core, this program tests all numbers in an interval & tallies primes
-	Three implentations execute this operation across 1,2,and 4 threads
+	The same operation then runs on a work-stealing thread pool, with 1, 2, 4 ... N threads
+	(N: one per core, or --threads N); the interval is cut into many small tasks so the load balances itself
+	primeTest may be swapped for a deterministic Miller-Rabin test (--miller-rabin)
+	or for batched trial division across AVX2/AVX-512 lanes (--batch)
+	or for trial division by a compile-time prime table, over wheel (mod 210) candidates only (--wheel)
 	Runtime for each implementation is measured with the chrono library
 	so long as the system has as many cores as threads, 
 	performance should increase
+	Batched trial division (widest kernel the CPU supports) counts the interval once more, single thread,
+	& then trial division by primes alone, testing only numbers coprime to 30, then to 210
+	A segmented sieve then counts the same interval without testing any number by division,
+	on one thread & then on the pool (each worker sieving its own segments)
+		./a.out --sieve N	counts primes up to N with the parallel sieve alone (N up to ~10^12)
+	& once more by Meissel-Lehmer, which finds pi(n) without visiting each prime
+		./a.out --pi N	pi(N) alone, for N far past the sieve's reach (10^14 in seconds); checked by the sieve up to 10^10
+		./a.out --count A B	primes in [A, B] by the sieve (narrow ranges) or pi(B) - pi(A - 1) (wide ones)
+	Built as C++20, the pool count is repeated as coroutines: each subrange a Task awaited through whenAll,
+	scheduled onto one long-lived pool, & composed with the sieve count into a single task
+	Finally both primality tests are timed on random 32 & 64-bit numbers
+		./a.out --is-prime N	tests a single number (any 64-bit N) with Miller-Rabin
+	Primes themselves can be streamed, in order & in bounded memory, optionally to a compact file:
+		./a.out --enumerate A B [--out FILE]	primes of [A, B]; FILE holds each gap as a varint (~1 byte per prime)
+	Per-thread results are combined by a generic parallel reduce over cache-line-padded accumulators
+		./a.out --false-sharing	times packed vs padded per-thread counters, 1 to N threads
+	Scaling sweep, one CSV row (or, with --json, JSON line) per engine, range & thread count:
+		./a.out --scale [--scale-threads 1,2,4,8] [--scale-sizes 1e6,1e7] [--repeat R] [--json]
+	Pool workers may be pinned to CPUs, filling one socket first or spread across sockets; the CPUs used are printed
+		./a.out --pin compact|spread ...	pin every pool (any mode above) & show the topology found in sysfs
+		./a.out --topology	print NUMA nodes, sockets, cores & usable CPUs, then exit
+	Hardware counters (perf_event_open) can be read per worker & printed under the pool timings (--enumerate, --sieve, --pi, --count too), or added to the sweep:
+		./a.out --perf ...	cycles, IPC, branch/L1d/LLC misses, task-clock, context switches & migrations
 
 	Designed and tested on UbuntuLinux w/ g++ compiler
 	FOR THREADS LIB - compile with pthread link:
 		g++ -pthread threads.cpp
+	coroutine tasks need C++20 (left out otherwise):
+		g++ -std=c++20 -pthread threads.cpp
 */
 #include <iostream>
 #include <cmath>	//fmod - prime function
+#include <cstdint>
+#include <cstring>	//memcpy - sieve presieve pattern
+#include <cstdlib>	//strtoull
+#include <cctype>	//isdigit - command-line numbers
+#include <string>
+#include <vector>	//sieve segments & sieving primes
+#include <algorithm>	//min, max
+#include <array>	//compile-time prime table
 #include <thread>	//multiple threads - must link compilation (g++ Opet_Stephen_primeThreads.cpp -lpthread)
+#include <mutex>	//work-stealing pool
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>	//unique_ptr
+#include <cstdio>	//prime files
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>	//Task, whenAll - needs -std=c++20
+#endif
+#include <random>	//primality benchmark inputs
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>	//AVX2/AVX-512 batch trial division
+#endif
 #include <unistd.h>
+#include <pthread.h>	//pthread_setaffinity_np - worker placement
+#include <sched.h>	//cpu_set_t, sched_getaffinity
+#include <tuple>
+#include <linux/perf_event.h>	//hardware counters (--perf)
+#include <sys/syscall.h>	//perf_event_open has no libc wrapper
+#include <sys/ioctl.h>
+#include <cerrno>
 using namespace std;
 
 /* We are going to measure the computational cost
@@ -47,26 +105,1821 @@ bool primeTest(uint64_t n){
     if (n <= 1)  return false; 
     else if (n <= 3)  return true; 
     else if (n%2 == 0 || n%3 == 0) return false; 
-    for (int i=5; i*i<=n; i=i+6) 
+    for (uint64_t i=5; i<=n/i; i=i+6) 	//i <= n/i: i*i overflows for n near 2^64
         if (n%i == 0 || n%(i+2) == 0) 
            return false; 
   
     return true;
 }
 
-void countPrimes(uint32_t a, uint32_t b, uint64_t* primeCount) {
+/* Deterministic Miller-Rabin for every 64-bit n
+	n - 1 = d * 2^s; n is a strong probable prime to base a if a^d = 1 or a^(d*2^r) = -1 (mod n) for some r < s
+	checking the seven bases below proves primality for all n < 2^64 (Jim Sinclair's set), so the
+	answer is exact - about 7 * 64 modular squarings instead of sqrt(n)/3 divisions
+	products are reduced by Montgomery multiplication: two 64x64->128 multiplies & a subtraction, no division	*/
+class Montgomery {
+private:
+	uint64_t n, inverse, r2;	//modulus (odd), n^-1 mod 2^64, 2^128 mod n
 
+public:
+	Montgomery(uint64_t modulus) : n(modulus), inverse(modulus){
+		for(int i = 0; i < 5; i++){inverse *= 2 - n * inverse;}	//Newton: each step doubles the correct low bits
+		uint64_t r = (0 - n) % n;	//2^64 mod n
+		r2 = (unsigned __int128)r * r % n;
+	}
+
+	//a * b / 2^64 mod n, for a, b < n
+	uint64_t multiply(uint64_t a, uint64_t b) const{
+		unsigned __int128 t = (unsigned __int128)a * b;
+		uint64_t m = (uint64_t)t * inverse;	//m * n has the same low 64 bits as t ...
+		uint64_t high = t >> 64, mn = ((unsigned __int128)m * n) >> 64;
+		return (high >= mn) ? high - mn : high - mn + n;	//... so (t - m * n) / 2^64 is exact
+	}
+	uint64_t toForm(uint64_t a) const{ return multiply(a % n, r2); }
+	uint64_t fromForm(uint64_t a) const{ return multiply(a, 1); }
+	uint64_t power(uint64_t base, uint64_t e) const{	//base & result in Montgomery form
+		uint64_t result = toForm(1);
+		for(; e; e >>= 1){
+			if(e & 1){result = multiply(result, base);}
+			base = multiply(base, base);
+		}
+		return result;
+	}
+};
+
+bool millerRabin(uint64_t n){
+	static const uint32_t small[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+	for(uint32_t p : small){	//cheap rejections first; also leaves n odd for Montgomery
+		if(n % p == 0){return n == p;}
+	}
+	if(n < 37 * 37){return n > 1;}
+
+	static const uint64_t bases[] = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+	Montgomery m(n);
+	uint64_t one = m.toForm(1), minusOne = m.toForm(n - 1);
+	uint64_t d = n - 1;
+	int s = __builtin_ctzll(d);
+	d >>= s;
+	for(uint64_t a : bases){
+		if(a % n == 0){continue;}	//a base that is a multiple of n proves nothing
+		uint64_t x = m.power(m.toForm(a), d);
+		if(x == one || x == minusOne){continue;}
+		int r = 1;
+		for(; r < s; r++){
+			x = m.multiply(x, x);
+			if(x == minusOne){break;}
+		}
+		if(r == s){return false;}	//never reached -1: a witnesses that n is composite
+	}
+	return true;
+}
+
+/* Compile-time prime table & wheels (--wheel)
+	smallPrimes, every prime below 2^16, is sieved by the compiler (constexpr): no startup cost, & enough
+	to trial-divide any 32-bit number by primes alone
+	a wheel of modulus M = 2*3*5 (30) or 2*3*5*7 (210) holds the residues mod M that share no factor with M -
+	8 of 30, 48 of 210; every prime but the wheel's own is one of them, so stepping from spoke to spoke
+	skips 73% (mod 30) or 77% (mod 210) of all numbers before any division	*/
+template<uint32_t Limit>
+struct CompileTimeSieve {
+	bool composite[Limit] = {};
+	constexpr CompileTimeSieve(){
+		composite[0] = composite[1] = true;
+		for(uint32_t i = 2; i * i < Limit; i++){
+			if(composite[i]){continue;}
+			for(uint32_t j = i * i; j < Limit; j += i){composite[j] = true;}
+		}
+	}
+};
+
+template<uint32_t Limit>
+constexpr uint32_t primesBelow(){
+	CompileTimeSieve<Limit> sieve;
+	uint32_t count = 0;
+	for(uint32_t i = 0; i < Limit; i++){count += !sieve.composite[i];}
+	return count;
+}
+
+template<uint32_t Limit>
+constexpr array<uint32_t, primesBelow<Limit>()> makePrimeTable(){
+	CompileTimeSieve<Limit> sieve;
+	array<uint32_t, primesBelow<Limit>()> table{};
+	size_t k = 0;
+	for(uint32_t i = 0; i < Limit; i++){ if(!sieve.composite[i]){table[k++] = i;} }
+	return table;
+}
+
+const uint32_t smallPrimeLimit = 1 << 16;
+constexpr array<uint32_t, primesBelow<smallPrimeLimit>()> smallPrimes = makePrimeTable<smallPrimeLimit>();
+static_assert(smallPrimes.size() == 6542 && smallPrimes.back() == 65521, "the primes below 2^16");
+
+constexpr uint32_t gcd32(uint32_t a, uint32_t b){ return b ? gcd32(b, a % b) : a; }
+
+constexpr uint32_t totient(uint32_t m){
 	uint32_t count = 0;
+	for(uint32_t r = 1; r < m; r++){count += (gcd32(r, m) == 1);}
+	return count;
+}
+
+template<uint32_t M>
+struct Wheel {
+	static constexpr uint32_t modulus = M;
+	static constexpr uint32_t spokes = totient(M);
+	uint32_t basis[8] = {};		//the primes dividing M: 2, 3, 5 (, 7) - the first entries of smallPrimes
+	uint32_t basisCount = 0;
+	uint32_t residues[spokes] = {};	//ascending residues coprime to M
+	uint32_t gaps[spokes] = {};		//from each spoke to the next (the last wraps round to the first, + M)
+	uint8_t firstSpoke[M] = {};		//for any r < M, the first spoke with residue >= r (spokes: none, next turn)
+
+	constexpr Wheel(){
+		for(uint32_t p = 2; p < M; p++){ if(M % p == 0 && totient(p) == p - 1){basis[basisCount++] = p;} }	//prime factors
+		uint32_t s = 0;
+		for(uint32_t r = 1; r < M; r++){ if(gcd32(r, M) == 1){residues[s++] = r;} }
+		for(s = 0; s < spokes; s++){gaps[s] = (s + 1 < spokes) ? residues[s + 1] - residues[s] : M + residues[0] - residues[s];}
+		for(uint32_t r = 0, next = 0; r < M; r++){
+			while(next < spokes && residues[next] < r){next++;}
+			firstSpoke[r] = next;
+		}
+	}
+};
+
+template<uint32_t M>
+constexpr Wheel<M> wheel{};
+static_assert(wheel<30>.spokes == 8 && wheel<30>.basisCount == 3, "2 * 3 * 5");
+static_assert(wheel<210>.spokes == 48 && wheel<210>.basisCount == 4 && wheel<210>.gaps[47] == 2, "2 * 3 * 5 * 7");
+
+//every number in [a, b] the wheel can't rule out: the wheel's own primes, then those coprime to M, ascending
+template<uint32_t M, typename F>
+void forEachWheelCandidate(uint64_t a, uint64_t b, F visit){
+	const Wheel<M>& w = wheel<M>;
+	a = max<uint64_t>(a, 2);
+	for(uint32_t i = 0; i < w.basisCount; i++){ if(w.basis[i] >= a && w.basis[i] <= b){visit(uint64_t(w.basis[i]));} }
+	if(a > b){return;}
+	uint64_t base = a - a % M;
+	uint32_t s = w.firstSpoke[a % M];
+	if(s == w.spokes){ s = 0; base += M; }
+	for(uint64_t c = base + w.residues[s]; c <= b; c = base + w.residues[s]){
+		visit(c);
+		if(++s == w.spokes){ s = 0; base += M; }
+	}
+}
+
+//true when n > 1 has no prime factor below smallPrimes[first] & none from there to sqrt(n)
+//n < 2^32 needs only the table; past it, divisors keep coming off the 210-wheel
+bool trialDivideFrom(uint64_t n, size_t first){
+	if(n <= UINT32_MAX){	//32-bit divides are the cheaper ones
+		uint32_t m = n;
+		for(size_t i = first; i < smallPrimes.size(); i++){
+			uint32_t p = smallPrimes[i];
+			if(p > m / p){return true;}
+			if(m % p == 0){return false;}
+		}
+		return true;
+	}
+	for(size_t i = first; i < smallPrimes.size(); i++){ if(n % smallPrimes[i] == 0){return false;} }
+	const Wheel<210>& w = wheel<210>;
+	uint64_t d = smallPrimeLimit - smallPrimeLimit % 210;
+	uint32_t s = w.firstSpoke[smallPrimeLimit % 210];
+	for(d += w.residues[s]; d <= n / d; d += w.gaps[s], s = (s + 1) % w.spokes){ if(n % d == 0){return false;} }
+	return true;
+}
+
+//trial division by primes (then wheel spokes) instead of every 6k +- 1
+bool primeTestWheel(uint64_t n){
+	const Wheel<210>& w = wheel<210>;
+	for(uint32_t i = 0; i < w.basisCount; i++){ if(n % w.basis[i] == 0){return n == w.basis[i];} }
+	return n > 1 && trialDivideFrom(n, w.basisCount);
+}
+
+/* Batch trial division (--batch)
+	tests many 32-bit candidates together, 16 (AVX-512) or 8 (AVX2) at a time, one per vector lane
+	no % at all: an odd d divides n exactly when n * inverse(d) mod 2^32 <= (2^32 - 1) / d, where inverse(d) is
+	d's multiplicative inverse mod 2^32 (Granlund & Montgomery) - so each prime costs one multiply & one compare
+	a lane is done once a prime divides it (composite) or the prime's square passes it (prime); the batch
+	steps through the primes up to 65521 (enough for any 32-bit n) until every lane is done
+	the kernel is picked once at runtime: AVX-512, AVX2, or a scalar loop using the same multiply test	*/
+struct TrialDivisors {
+	vector<uint32_t> inverse, limit, square;	//per odd prime 3 .. 65521
+};
+
+const TrialDivisors& trialDivisors(){
+	static const TrialDivisors table = []{
+		TrialDivisors t;
+		for(uint32_t p : smallPrimes){
+			if(p == 2){continue;}
+			uint32_t inv = p;
+			for(int i = 0; i < 4; i++){inv *= 2 - p * inv;}	//Newton: 3 -> 6 -> 12 -> 24 -> 48 correct low bits
+			t.inverse.push_back(inv);
+			t.limit.push_back(UINT32_MAX / p);
+			t.square.push_back(p * p);
+		}
+		while(t.square.size() % 4){	//pad for the unrolled kernels: divides no odd n, & never "passed"
+			t.inverse.push_back(1);
+			t.limit.push_back(0);
+			t.square.push_back(UINT32_MAX);
+		}
+		return t;
+	}();
+	return table;
+}
+
+//the answer for lanes the kernels don't decide: n < 2 & even n
+inline bool trivialVerdict(uint32_t n, bool survived){
+	if(n < 2){return false;}
+	if(n % 2 == 0){return n == 2;}
+	return survived;
+}
+
+bool primeTestScalarInverse(uint32_t n){
+	const TrialDivisors& d = trialDivisors();
+	if(n < 2 || n % 2 == 0){return trivialVerdict(n, true);}
+	for(size_t k = 0; k < d.square.size() && d.square[k] <= n; k++){
+		if(n * d.inverse[k] <= d.limit[k]){return false;}
+	}
+	return true;
+}
 
-	for(; a <= b; a++){
-		if(primeTest(a))
+void primeTestBatchScalar(const uint32_t* n, size_t count, uint8_t* prime){
+	for(size_t i = 0; i < count; i++){prime[i] = primeTestScalarInverse(n[i]);}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) void primeTestBatchAVX2(const uint32_t* n, size_t count, uint8_t* prime){
+	const TrialDivisors& d = trialDivisors();
+	size_t i = 0;
+	for(; i + 8 <= count; i += 8){
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(n + i));
+		__m256i open = _mm256_set1_epi32(-1), composite = _mm256_setzero_si256();
+		for(size_t k = 0; k < d.square.size(); k += 4){	//the exit test costs a branch, so it runs once per 4 primes
+			for(size_t u = k; u < k + 4; u++){
+				__m256i square = _mm256_set1_epi32(d.square[u]);
+				open = _mm256_and_si256(open, _mm256_cmpeq_epi32(_mm256_min_epu32(square, v), square));	//square <= n
+				__m256i product = _mm256_mullo_epi32(v, _mm256_set1_epi32(d.inverse[u]));
+				__m256i limit = _mm256_set1_epi32(d.limit[u]);
+				__m256i divides = _mm256_cmpeq_epi32(_mm256_min_epu32(product, limit), product);	//product <= limit
+				composite = _mm256_or_si256(composite, _mm256_and_si256(open, divides));
+				open = _mm256_andnot_si256(divides, open);
+			}
+			if(_mm256_testz_si256(open, open)){break;}
+		}
+		unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(composite));
+		for(int j = 0; j < 8; j++){prime[i + j] = trivialVerdict(n[i + j], !((mask >> j) & 1));}
+	}
+	primeTestBatchScalar(n + i, count - i, prime + i);
+}
+
+__attribute__((target("avx512f"))) void primeTestBatchAVX512(const uint32_t* n, size_t count, uint8_t* prime){
+	const TrialDivisors& d = trialDivisors();
+	size_t i = 0;
+	for(; i + 16 <= count; i += 16){
+		__m512i v = _mm512_loadu_si512(n + i);
+		__mmask16 open = 0xFFFF, composite = 0;
+		for(size_t k = 0; k < d.square.size(); k += 4){
+			for(size_t u = k; u < k + 4; u++){
+				open &= _mm512_cmple_epu32_mask(_mm512_set1_epi32(d.square[u]), v);
+				__m512i product = _mm512_mullo_epi32(v, _mm512_set1_epi32(d.inverse[u]));
+				__mmask16 divides = _mm512_cmple_epu32_mask(product, _mm512_set1_epi32(d.limit[u]));	//unmasked: keeps open off the compare's latency
+				composite |= open & divides;
+				open &= ~divides;
+			}
+			if(!open){break;}
+		}
+		for(int j = 0; j < 16; j++){prime[i + j] = trivialVerdict(n[i + j], !((composite >> j) & 1));}
+	}
+	primeTestBatchScalar(n + i, count - i, prime + i);
+}
+#endif
+
+typedef void (*BatchKernel)(const uint32_t*, size_t, uint8_t*);
+
+//the widest kernel this CPU runs, & its name
+BatchKernel batchKernel(const char** name = nullptr){
+	static const char* chosen = "scalar";
+	static const BatchKernel kernel = []{
+#if defined(__x86_64__) || defined(__i386__)
+		if(__builtin_cpu_supports("avx512f")){ chosen = "AVX-512"; return primeTestBatchAVX512; }
+		if(__builtin_cpu_supports("avx2")){ chosen = "AVX2"; return primeTestBatchAVX2; }
+#endif
+		return primeTestBatchScalar;
+	}();
+	if(name){*name = chosen;}
+	return kernel;
+}
+
+//prime[i] = whether n[i] is prime, for every 32-bit n
+void primeTestBatch(const uint32_t* n, size_t count, uint8_t* prime){
+	batchKernel()(n, count, prime);
+}
+
+//single-number form, so the batch kernel can stand in for primeTest; countPrimes spots it & batches instead
+bool primeTestBatched(uint64_t n){
+	if(n > UINT32_MAX){return primeTest(n);}
+	uint32_t candidate = n;
+	uint8_t prime;
+	primeTestBatch(&candidate, 1, &prime);
+	return prime;
+}
+
+//primes in [a, b] by the batch kernel: the candidates of the 210-wheel, in batches
+uint64_t countPrimesBatched(uint32_t a, uint32_t b){
+	const size_t batch = 4096;
+	uint32_t candidates[batch];
+	uint8_t prime[batch];
+	uint64_t count = 0;
+	size_t filled = 0;
+	forEachWheelCandidate<210>(a, b, [&](uint64_t c){
+		candidates[filled++] = c;
+		if(filled == batch){
+			primeTestBatch(candidates, filled, prime);
+			for(size_t i = 0; i < filled; i++){count += prime[i];}
+			filled = 0;
+		}
+	});
+	primeTestBatch(candidates, filled, prime);
+	for(size_t i = 0; i < filled; i++){count += prime[i];}
+	return count;
+}
+
+//the test countPrimes applies to each number: primeTest (trial division), millerRabin, primeTestBatched or primeTestWheel
+typedef bool (*PrimalityTest)(uint64_t);
+
+//countPrimes over the candidates of a wheel (mod 30 or 210) only; with primeTestWheel, the default, the
+//candidates are known to be coprime to M & trial division starts past the wheel's primes
+template<uint32_t M = 210>
+uint64_t countPrimesWheel(uint32_t a, uint32_t b, PrimalityTest isPrime = primeTestWheel){
+	uint64_t count = 0;
+	if(isPrime == primeTestWheel){forEachWheelCandidate<M>(a, b, [&](uint64_t c){ count += trialDivideFrom(c, wheel<M>.basisCount); });}	//the wheel's primes pass too
+	else{forEachWheelCandidate<M>(a, b, [&](uint64_t c){ count += isPrime(c); });}
+	return count;
+}
+
+uint64_t countPrimes(uint32_t a, uint32_t b, PrimalityTest isPrime = primeTest) {
+	if(isPrime == primeTestBatched){return countPrimesBatched(a, b);}	//same answers, many numbers per call
+	if(isPrime == primeTestWheel){return countPrimesWheel(a, b);}		//same answers, 48 of every 210 numbers tested
+
+	uint64_t count = 0;
+
+	for(uint64_t i = a; i <= b; i++){	//64-bit, so b = 2^32 - 1 ends the loop
+		if(isPrime(i))
 			count++;
 	}
 
-	(*primeCount) = count;
+	return count;
+}
+
+/* Segmented Sieve of Eratosthenes
+	counts the same primes as primeTest, but crosses off multiples instead of dividing every number
+	odd numbers only, one bit each: bit i of a segment starting at (even) low stands for low + 1 + 2i
+	the range is swept in segments of sieveSegmentBytes, small enough to stay in cache while
+	every sieving prime up to sqrt(b) crosses off its multiples
+	multiples of 3, 5, 7, 11 & 13 are not crossed off one by one: a precomputed bit pattern
+	(period 3*5*7*11*13 = 15015 odd numbers) is copied in first
+	each sieving prime remembers its next multiple, so a sweep divides once per prime, not once per segment
+	assumes a little-endian machine (bytes of the pattern are copied into 64-bit words)	*/
+const uint64_t sieveSegmentBytes = 256 * 1024;	//fits L2 with room to spare; see README for timings
+const uint64_t sieveSegmentBits = sieveSegmentBytes * 8;
+const uint32_t presievePeriod = 3 * 5 * 7 * 11 * 13;
+const uint32_t presieveInverse8 = 1877;		//8 * 1877 = 1 (mod 15015): bit offset -> byte offset
+//the sieve keeps every prime up to sqrt(b) & each worker a next multiple per prime, so b is capped:
+//at 10^15 that is ~1.9M primes - 8 MB shared & 16 MB per worker (plus 32 MB while finding them)
+const uint64_t sieveMaxLimit = 1000000000000000ull;
+
+//odd primes up to limit, by a plain sieve - the sieving primes for ranges up to limit^2
+vector<uint32_t> sievingPrimes(uint32_t limit){
+	vector<char> composite(uint64_t(limit) + 1, 0);
+	vector<uint32_t> primes;
+	for(uint64_t i = 3; i <= limit; i += 2){
+		if(composite[i]){continue;}
+		primes.push_back(i);
+		for(uint64_t j = i * i; j <= limit; j += 2 * i){composite[j] = 1;}
+	}
+	return primes;
+}
+
+//integer square root, exact for all 64-bit values: the double's guess is capped at 2^32 - 1 & corrected
+//by division, since (r + 1)^2 overflows near the top of the range
+constexpr uint64_t isqrt(uint64_t n){
+	uint64_t r = min<uint64_t>(sqrt((double)n), 0xFFFFFFFF);
+	while(r > n / max<uint64_t>(r, 1)){r--;}
+	while(r < 0xFFFFFFFF && r + 1 <= n / (r + 1)){r++;}
+	return r;
+}
+static_assert(isqrt(~uint64_t(0)) == 0xFFFFFFFF && isqrt(0xFFFFFFFE00000001ull) == 0xFFFFFFFF && isqrt(0xFFFFFFFE00000000ull) == 0xFFFFFFFE, "the top of the 64-bit range");
+static_assert(isqrt(0) == 0 && isqrt(99) == 9 && isqrt(100) == 10, "small values");
+
+//one segment buffer & the sieving state of one sweep; reusable across sweeps
+class SegmentedSieve {
+private:
+	const vector<uint32_t>& primes;		//odd sieving primes, ascending; must reach sqrt of any range swept
+	vector<uint64_t> bits;				//1: composite
+	vector<uint64_t> nextMultiple;		//per sieving prime, the next odd multiple still to cross off
+	size_t firstPrime;					//index of the first prime past the presieve pattern
+
+	//a + b, or 2^64 - 1 where that would wrap: the multiple past every 64-bit number - crossing it off
+	//is harmless, as 3 divides 2^64 - 1
+	static uint64_t capped(uint64_t a, uint64_t b){ return (b > ~uint64_t(0) - a) ? ~uint64_t(0) : a + b; }
+
+	static const vector<uint8_t>& presievePattern(){	//bit j: 2j + 1 is a multiple of 3, 5, 7, 11 or 13
+		static const vector<uint8_t> pattern = []{
+			vector<uint8_t> p(presievePeriod, 0);
+			for(uint32_t q : {3, 5, 7, 11, 13}){
+				for(uint64_t j = q / 2; j < 8ull * presievePeriod; j += q){p[j / 8] |= 1 << (j % 8);}
+			}
+			return p;
+		}();
+		return pattern;
+	}
+
+	//cross off the segment [low, low + 2 * words * 64) into out; low is even
+	void sieveSegment(uint64_t low, size_t words, uint64_t* out){
+		const vector<uint8_t>& pattern = presievePattern();
+		uint8_t* bytesOut = reinterpret_cast<uint8_t*>(out);
+		size_t bytes = words * 8;
+		for(size_t k = (low / 2) % presievePeriod * presieveInverse8 % presievePeriod, done = 0; done < bytes; k = 0){
+			size_t n = min<size_t>(presievePeriod - k, bytes - done);
+			memcpy(bytesOut + done, pattern.data() + k, n);
+			done += n;
+		}
+		if(low == 0){	//the pattern's own primes are prime; 1 is not
+			out[0] &= ~uint64_t(0x6E);	//3, 5, 7, 11 & 13: bits 1, 2, 3, 5 & 6
+			out[0] |= 1;
+		}
+
+		uint64_t last = capped(low, 2 * 64 * words - 1);	//the segment's last number, short of 2^64
+		for(size_t i = firstPrime; i < primes.size(); i++){
+			uint64_t m = nextMultiple[i];
+			if(m > last){
+				if(uint64_t(primes[i]) * primes[i] > last){break;}	//no larger prime reaches this segment either
+				continue;
+			}
+			uint64_t step = primes[i];
+			uint64_t bit = (m - low) / 2;	//m is odd & low is even
+			uint64_t end = words * 64;
+			for(; bit < end; bit += step){out[bit / 64] |= uint64_t(1) << (bit % 64);}
+			nextMultiple[i] = capped(low + 1, 2 * bit);
+		}
+	}
+
+	//first odd multiple >= max(p^2, low) of every sieving prime
+	void startAt(uint64_t low){
+		nextMultiple.resize(primes.size());
+		for(size_t i = firstPrime; i < primes.size(); i++){
+			uint64_t p = primes[i];
+			uint64_t m = (low <= p * p) ? p * p : capped(low, (p - low % p) % p);
+			nextMultiple[i] = (m % 2) ? m : capped(m, p);
+		}
+	}
+
+	//sweep [a, b] segment by segment; visit(low, words) sees each sieved segment in order
+	template<typename F>
+	void sweep(uint64_t a, uint64_t b, F visit){
+		uint64_t low = firstSegment(a);
+		bits.resize(sieveSegmentBits / 64);
+		startAt(low);
+		while(low <= b){
+			size_t words = segmentWords(low, b);
+			sieveSegment(low, words, bits.data());
+			visit(low, words);
+			if(b - low < 2 * 64 * words){break;}	//done - & low may be about to wrap
+			low += 2 * 64 * words;
+		}
+	}
+
+public:
+	SegmentedSieve(const vector<uint32_t>& sieving) : primes(sieving), firstPrime(0){
+		while(firstPrime < primes.size() && primes[firstPrime] <= 13){firstPrime++;}
+	}
+
+	static uint64_t firstSegment(uint64_t a){ return a & ~uint64_t(127); }	//segments start on a word boundary of odd numbers
+	static size_t segmentWords(uint64_t low, uint64_t b){ return (min<uint64_t>(sieveSegmentBits, (b - low) / 2 + 1) + 63) / 64; }
+
+	//sieve the one segment starting at low into out (words long), wherever the last sweep left off
+	void sieveAt(uint64_t low, size_t words, uint64_t* out){
+		startAt(low);
+		sieveSegment(low, words, out);
+	}
+
+	//visit(p) for every odd prime of a sieved segment that lies in [a, b], ascending
+	//a word at a time: invert, then peel off the lowest set bit until none are left
+	template<typename F>
+	static void forEachPrimeIn(const uint64_t* segment, uint64_t low, size_t words, uint64_t a, uint64_t b, F& visit){
+		uint64_t first = (a > low) ? (a - low) / 2 : 0;	//bits of odd numbers >= a ...
+		uint64_t last = min<uint64_t>(words * 64, (b - low) / 2 + (b - low) % 2);	//... & <= b
+		for(uint64_t w = first / 64; w * 64 < last; w++){
+			uint64_t primesHere = ~segment[w];
+			if(w == first / 64){primesHere &= ~uint64_t(0) << (first % 64);}
+			if(w == (last - 1) / 64 && last % 64){primesHere &= ~(~uint64_t(0) << (last % 64));}
+			uint64_t base = low + 1 + 128 * w;
+			for(; primesHere; primesHere &= primesHere - 1){visit(base + 2 * __builtin_ctzll(primesHere));}
+		}
+	}
+
+	//visit(p) for every prime in [a, b], ascending, in one segment's worth of memory
+	template<typename F>
+	void forEachPrime(uint64_t a, uint64_t b, F visit){
+		if(a > b){return;}
+		if(a <= 2 && b >= 2){visit(uint64_t(2));}
+		sweep(a, b, [&](uint64_t low, size_t words){ forEachPrimeIn(bits.data(), low, words, a, b, visit); });
+	}
+
+	//number of primes in [a, b]; sieving primes must reach sqrt(b)
+	uint64_t count(uint64_t a, uint64_t b){
+		if(a > b){return 0;}
+		uint64_t total = (a <= 2 && b >= 2) ? 1 : 0;	//the one even prime
+		sweep(a, b, [&](uint64_t low, size_t words){
+			uint64_t first = (a > low) ? (a - low) / 2 : 0;	//bits of odd numbers >= a ...
+			uint64_t last = min<uint64_t>(words * 64, (b - low) / 2 + (b - low) % 2);	//... & <= b
+			for(uint64_t w = first / 64; w * 64 < last; w++){
+				uint64_t primesHere = ~bits[w];
+				if(w == first / 64){primesHere &= ~uint64_t(0) << (first % 64);}
+				if(w == (last - 1) / 64 && last % 64){primesHere &= ~(~uint64_t(0) << (last % 64));}
+				total += __builtin_popcountll(primesHere);
+			}
+		});
+		return total;
+	}
+};
+
+//sieve counterpart to countPrimes: primes in [a, b], for b up to ~10^12 (and beyond, given time)
+uint64_t countPrimesSieve(uint64_t a, uint64_t b){
+	vector<uint32_t> primes = sievingPrimes(isqrt(b));
+	SegmentedSieve sieve(primes);
+	return sieve.count(a, b);
+}
+
+/* CPU topology & worker placement
+	the logical CPUs this process may run on (its affinity mask - taskset & cgroups narrow it) are read
+	from sysfs along with their socket, core & NUMA node; where sysfs is missing each CPU is its own core
+	a placement lists the CPU each pool worker is pinned to (pthread_setaffinity_np):
+		compact	fill one node/socket before the next - workers share caches & local memory
+		spread	deal workers round robin across nodes/sockets - more memory bandwidth & total cache
+	within a socket, every physical core gets a worker before its second hyperthread - compact fills a whole
+	socket, hyperthreads included, before the next; spread reaches them on every socket alike
+	more workers than CPUs wrap around
+	with no placement (the default) the OS schedules workers as it likes	*/
+struct LogicalCpu {
+	unsigned cpu, package, core, node;
+	unsigned smt;	//0 for the first hyperthread of a core, 1 for the second ...
+};
+
+struct Topology {
+	vector<LogicalCpu> cpus;	//the usable ones, by cpu number
+	unsigned packages = 0, cores = 0, nodes = 0;
+};
+
+//"0-3,8,10-11" (sysfs cpu list) -> 0 1 2 3 8 10 11
+vector<unsigned> parseCpuList(const char* text){
+	vector<unsigned> cpus;
+	for(const char* p = text; *p;){
+		char* end;
+		unsigned first = strtoul(p, &end, 10), last = first;
+		if(end == p){break;}
+		if(*end == '-'){ p = end + 1; last = strtoul(p, &end, 10); }
+		for(unsigned c = first; c <= last; c++){cpus.push_back(c);}
+		p = (*end == ',') ? end + 1 : end;
+	}
+	return cpus;
+}
+
+//first line of a sysfs file, or "" if it can't be read
+string readSysfs(const string& path){
+	char line[4096] = "";
+	FILE* f = fopen(path.c_str(), "r");
+	if(!f){return "";}
+	if(!fgets(line, sizeof(line), f)){line[0] = 0;}
+	fclose(f);
+	string s = line;
+	while(!s.empty() && (s.back() == '\n' || s.back() == ' ')){s.pop_back();}
+	return s;
+}
+
+Topology readTopology(){
+	Topology topo;
+	cpu_set_t allowed;
+	CPU_ZERO(&allowed);
+	if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0){ for(unsigned c = 0; c < max(1u, thread::hardware_concurrency()); c++){CPU_SET(c, &allowed);} }
+
+	vector<unsigned> nodeOf(CPU_SETSIZE, 0);
+	string nodes = readSysfs("/sys/devices/system/node/online");
+	for(unsigned node : parseCpuList(nodes.c_str())){
+		for(unsigned c : parseCpuList(readSysfs("/sys/devices/system/node/node" + to_string(node) + "/cpulist").c_str())){ if(c < CPU_SETSIZE){nodeOf[c] = node;} }
+	}
+
+	for(unsigned c = 0; c < CPU_SETSIZE; c++){
+		if(!CPU_ISSET(c, &allowed)){continue;}
+		string dir = "/sys/devices/system/cpu/cpu" + to_string(c) + "/topology/";
+		string package = readSysfs(dir + "physical_package_id"), core = readSysfs(dir + "core_id");
+		topo.cpus.push_back({c, package.empty() ? 0 : (unsigned)stoul(package), core.empty() ? c : (unsigned)stoul(core), nodeOf[c], 0});
+	}
+	//number the hyperthreads of each core & count what we found
+	vector<pair<unsigned, unsigned> > seenCores;
+	vector<unsigned> seenPackages, seenNodes;
+	for(LogicalCpu& l : topo.cpus){
+		pair<unsigned, unsigned> core(l.package, l.core);
+		l.smt = count(seenCores.begin(), seenCores.end(), core);
+		seenCores.push_back(core);
+		if(l.smt == 0){topo.cores++;}
+		if(find(seenPackages.begin(), seenPackages.end(), l.package) == seenPackages.end()){seenPackages.push_back(l.package);}
+		if(find(seenNodes.begin(), seenNodes.end(), l.node) == seenNodes.end()){seenNodes.push_back(l.node);}
+	}
+	topo.packages = seenPackages.size();
+	topo.nodes = seenNodes.size();
+	return topo;
+}
+
+//0 1 2 3 8 -> "0-3,8" (repeats dropped)
+string formatCpuList(vector<unsigned> cpus){
+	sort(cpus.begin(), cpus.end());
+	cpus.erase(unique(cpus.begin(), cpus.end()), cpus.end());
+	string text;
+	for(size_t i = 0; i < cpus.size();){
+		size_t j = i;
+		while(j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1){j++;}
+		text += (text.empty() ? "" : ",") + to_string(cpus[i]) + (j > i ? "-" + to_string(cpus[j]) : "");
+		i = j + 1;
+	}
+	return text;
+}
+
+enum class PlacementPolicy { os, compact, spread };
+
+struct Placement {
+	PlacementPolicy policy = PlacementPolicy::os;
+	Topology topology;
+
+	//the CPU for each of the workers of a pool; empty: leave them to the OS
+	vector<unsigned> cpusFor(unsigned workers) const{
+		vector<LogicalCpu> order = topology.cpus;
+		if(policy == PlacementPolicy::os || order.empty()){return {};}
+		//compact: node by node, socket by socket, first hyperthreads first within each
+		sort(order.begin(), order.end(), [](const LogicalCpu& x, const LogicalCpu& y){
+			return make_tuple(x.node, x.package, x.smt, x.core, x.cpu) < make_tuple(y.node, y.package, y.smt, y.core, y.cpu);
+		});
+		if(policy == PlacementPolicy::spread){	//deal the compact order of each node/socket out round robin
+			vector<vector<LogicalCpu> > groups;
+			for(const LogicalCpu& l : order){
+				if(groups.empty() || groups.back()[0].node != l.node || groups.back()[0].package != l.package){groups.emplace_back();}
+				groups.back().push_back(l);
+			}
+			order.clear();
+			for(size_t i = 0; order.size() < topology.cpus.size(); i++){
+				for(vector<LogicalCpu>& g : groups){ if(i < g.size()){order.push_back(g[i]);} }
+			}
+		}
+		vector<unsigned> cpus(workers);
+		for(unsigned w = 0; w < workers; w++){cpus[w] = order[w % order.size()].cpu;}
+		return cpus;
+	}
+};
+
+const char* placementName(PlacementPolicy p){
+	return p == PlacementPolicy::compact ? "compact" : p == PlacementPolicy::spread ? "spread" : "os";
+}
+
+//pin the calling thread to one CPU; false if the kernel refused (CPU offline, or outside our cgroup)
+bool pinCurrentThread(unsigned cpu){
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/* Hardware performance counters (perf_event_open, --perf)
+	counters are opened per thread & count that thread only: cycles, instructions, branch misses,
+	L1d & last-level cache read misses in user mode (so perf_event_paranoid up to 2 allows them), plus
+	the kernel's software events - task-clock, context switches & CPU migrations
+	a counter the kernel refuses (no PMU, as in most VMs; paranoid 3; seccomp) is left out & reported
+	as unavailable, & the rest still count
+	with more hardware events open than the PMU has registers, the kernel time-shares them; counts are
+	scaled by time enabled / time running, as perf stat does	*/
+enum PerfEvent { perfCycles, perfInstructions, perfBranchMisses, perfL1dMisses, perfLlcMisses, perfTaskClock, perfContextSwitches, perfMigrations, perfEventCount };
+
+struct PerfCounts {
+	double value[perfEventCount] = {};
+	bool valid[perfEventCount] = {};	//false: the counter could not be opened
+
+	PerfCounts& operator +=(const PerfCounts& o){
+		for(int e = 0; e < perfEventCount; e++){ value[e] += o.value[e]; valid[e] = valid[e] || o.valid[e]; }
+		return *this;
+	}
+	bool has(PerfEvent e) const{ return valid[e]; }
+	double operator [](PerfEvent e) const{ return value[e]; }
+};
+
+class PerfCounters {
+private:
+	int fds[perfEventCount];
+
+	static int openEvent(PerfEvent e){
+		static const uint32_t types[perfEventCount] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE,
+			PERF_TYPE_SOFTWARE, PERF_TYPE_SOFTWARE, PERF_TYPE_SOFTWARE};
+		static const uint64_t configs[perfEventCount] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+			PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+			PERF_COUNT_SW_TASK_CLOCK, PERF_COUNT_SW_CONTEXT_SWITCHES, PERF_COUNT_SW_CPU_MIGRATIONS};
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = types[e];
+		attr.config = configs[e];
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.exclude_kernel = (types[e] != PERF_TYPE_SOFTWARE);	//switches & migrations happen in the kernel
+		attr.exclude_hv = 1;
+		int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);	//this thread, any CPU
+		if(fd < 0 && !attr.exclude_kernel){	//a stricter paranoid setting: user mode only, then
+			attr.exclude_kernel = 1;
+			fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+		}
+		return fd;
+	}
+
+public:
+	PerfCounters(){ for(int& fd : fds){fd = -1;} }
+	~PerfCounters(){ for(int fd : fds){ if(fd >= 0){close(fd);} } }
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator =(const PerfCounters&) = delete;
+
+	//start counting the calling thread (from zero); returns how many counters opened
+	int open(){
+		int opened = 0;
+		for(int e = 0; e < perfEventCount; e++){ if(fds[e] < 0){fds[e] = openEvent(PerfEvent(e));} opened += (fds[e] >= 0); }
+		return opened;
+	}
+	void reset(){ for(int fd : fds){ if(fd >= 0){ioctl(fd, PERF_EVENT_IOC_RESET, 0);} } }
+
+	//may be read from any thread
+	PerfCounts read() const{
+		PerfCounts counts;
+		for(int e = 0; e < perfEventCount; e++){
+			uint64_t v[3];	//value, time enabled, time running
+			if(fds[e] < 0 || ::read(fds[e], v, sizeof(v)) != sizeof(v)){continue;}
+			counts.valid[e] = true;
+			counts.value[e] = (v[2] && v[2] < v[1]) ? double(v[0]) * v[1] / v[2] : double(v[0]);
+		}
+		return counts;
+	}
+};
+
+//"" when the hardware counters work here, else why not (checked once, on the calling thread)
+string perfUnavailable(){
+	PerfCounters probe;
+	probe.open();
+	PerfCounts c = probe.read();
+	if(c.has(perfCycles) && c.has(perfInstructions)){return "";}
+	string paranoid = readSysfs("/proc/sys/kernel/perf_event_paranoid");
+	perf_event_attr attr;	//once more, for errno
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+	attr.exclude_kernel = attr.exclude_hv = 1;
+	int fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+	int error = errno;
+	if(fd >= 0){ close(fd); return "hardware counters partly unavailable"; }
+	if(error == ENOENT || error == EOPNOTSUPP){return "no hardware PMU (a VM without PMU passthrough?)";}
+	if(error == EACCES || error == EPERM){return "not permitted (perf_event_paranoid = " + (paranoid.empty() ? string("?") : paranoid) + ")";}
+	if(error == ENOSYS){return "perf_event_open not supported by this kernel";}
+	return strerror(error);
+}
+
+//one line of whichever counters opened; with numbers (the size of the range counted), also cycles per number
+string describePerf(const PerfCounts& c, uint64_t numbers){
+	char text[512];
+	string line;
+	if(c.has(perfCycles) && c.has(perfInstructions) && c[perfInstructions] > 0){
+		double ki = c[perfInstructions] / 1000;
+		snprintf(text, sizeof(text), "%.3g cycles, IPC %.2f", c[perfCycles], c[perfInstructions] / max(1.0, c[perfCycles]));
+		line += text;
+		if(numbers){ snprintf(text, sizeof(text), ", %.1f cycles/number", c[perfCycles] / numbers); line += text; }
+		const PerfEvent misses[] = {perfBranchMisses, perfL1dMisses, perfLlcMisses};
+		const char* names[] = {"branch", "L1d", "LLC"};
+		line += "; misses per 1000 instructions:";
+		for(int i = 0; i < 3; i++){
+			if(c.has(misses[i])){ snprintf(text, sizeof(text), " %s %.3f", names[i], c[misses[i]] / ki); line += text; }
+			else{line += string(" ") + names[i] + " n/a";}
+		}
+	}
+	if(c.has(perfTaskClock)){
+		snprintf(text, sizeof(text), "%stask-clock %.1fms, %.0f context switches, %.0f migrations", line.empty() ? "" : "; ",
+			c[perfTaskClock] / 1e6, c[perfContextSwitches], c[perfMigrations]);
+		line += text;
+	}
+	return line.empty() ? "no counters available" : line;
+}
+
+/* Work-stealing thread pool
+	every worker owns a deque of tasks: it takes new work from the back of its own deque, &
+	when that runs dry it steals from the front of the others' - so a worker stuck on an
+	expensive task never holds up the cheap ones queued behind it
+	submit() deals tasks out round robin (or, from inside a task, onto the submitting worker's own deque)
+	each deque has its own lock, so workers only contend when one steals from another; the pool-wide
+	lock m is only taken to sleep, & by a submit() that finds a worker asleep (or on its way there)
+	idle workers sleep until a task is submitted; wait() blocks until every submitted task has finished
+	given a list of CPUs (Placement::cpusFor), worker i pins itself to the i-th as it starts
+	with countEvents, every worker opens its own PerfCounters before the constructor returns	*/
+class WorkStealingPool {
+private:
+	struct alignas(64) TaskQueue {	//one cache line per lock, so neighbours' locks don't false-share
+		mutex m;
+		deque<function<void()>> tasks;
+	};
+	struct alignas(64) WorkerStats {	//written by its worker only; read once the pool is idle
+		atomic<uint64_t> busyNanos{0}, tasks{0};
+	};
+
+	vector<TaskQueue> queues;
+	vector<WorkerStats> stats;
+	vector<thread> workers;
+	vector<unsigned> placement;		//worker i runs on cpu placement[i]; empty: unpinned
+	atomic<unsigned> unpinned{0};	//workers the kernel would not pin
+	vector<PerfCounters> counters;	//one per worker when counting events, else none
+	unsigned started = 0;			//workers past setup (guarded by m)
+	atomic<size_t> queued{0};		//tasks sitting in (or being pushed onto) some deque
+	atomic<unsigned> sleepers{0};	//workers inside the sleep handshake below
+	atomic<size_t> unfinished{0};	//tasks submitted & not yet done
+	atomic<uint64_t> steals{0};
+	atomic<unsigned> nextQueue{0};	//round robin for submits from outside the pool
+	mutex m;						//guards sleeping: idle workers & wait() - never held while submitting to a busy pool
+	condition_variable wake, finished;
+	bool stopping = false;
+
+	static thread_local WorkStealingPool* currentPool;	//the pool the calling thread works for, if any
+	static thread_local unsigned currentWorker;
+
+	bool take(unsigned self, function<void()>& task){
+		{	//own deque first, newest task
+			lock_guard<mutex> lock(queues[self].m);
+			if(!queues[self].tasks.empty()){
+				task = move(queues[self].tasks.back());
+				queues[self].tasks.pop_back();
+				queued--;
+				return true;
+			}
+		}
+		for(unsigned i = 1; i < queues.size(); i++){	//then steal the oldest task of the next busy worker
+			TaskQueue& victim = queues[(self + i) % queues.size()];
+			lock_guard<mutex> lock(victim.m);
+			if(!victim.tasks.empty()){
+				task = move(victim.tasks.front());
+				victim.tasks.pop_front();
+				queued--;
+				steals++;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void run(unsigned self){
+		currentPool = this;
+		currentWorker = self;
+		if(!placement.empty() && !pinCurrentThread(placement[self])){unpinned++;}
+		if(!counters.empty()){counters[self].open();}
+		{ lock_guard<mutex> lock(m); started++; }
+		finished.notify_all();
+		function<void()> task;
+		while(true){
+			if(take(self, task)){
+				std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now();
+				task();
+				task = nullptr;	//release captures before announcing completion
+				stats[self].busyNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - a).count();
+				stats[self].tasks++;
+				if(--unfinished == 0){
+					lock_guard<mutex> lock(m);
+					finished.notify_all();
+				}
+				continue;
+			}
+			//announced before queued is checked, & submit() bumps queued before checking sleepers: one of
+			//the two always sees the other, so either this worker finds the task or submit() wakes it
+			unique_lock<mutex> lock(m);
+			sleepers++;
+			wake.wait(lock, [&]{ return stopping || queued > 0; });
+			sleepers--;
+			if(stopping && queued == 0){return;}
+		}
+	}
+
+public:
+	WorkStealingPool(unsigned threads, vector<unsigned> cpus = {}, bool countEvents = false)
+		: queues(max(1u, threads)), stats(queues.size()), placement(move(cpus)), counters(countEvents ? queues.size() : 0){
+		if(!placement.empty()){placement.resize(queues.size(), placement.back());}
+		for(unsigned t = 0; t < queues.size(); t++){workers.emplace_back(&WorkStealingPool::run, this, t);}
+		unique_lock<mutex> lock(m);	//every worker pinned & counting before any task is timed
+		finished.wait(lock, [&]{ return started == queues.size(); });
+	}
+	~WorkStealingPool(){
+		wait();
+		{ lock_guard<mutex> lock(m); stopping = true; }
+		wake.notify_all();
+		for(thread& t : workers){t.join();}
+	}
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator =(const WorkStealingPool&) = delete;
+
+	void submit(function<void()> task){
+		unsigned q = (currentPool == this) ? currentWorker : nextQueue++ % queues.size();
+		unfinished++;
+		queued++;	//counted before the push, so a worker taking the task can't decrement first & wrap the count
+		{
+			lock_guard<mutex> lock(queues[q].m);
+			queues[q].tasks.push_back(move(task));
+		}
+		if(sleepers > 0){	//m orders the wake-up after a sleeper's check of queued; a busy pool never takes it
+			{ lock_guard<mutex> lock(m); }
+			wake.notify_one();
+		}
+	}
+
+	//block until every task submitted so far (& any they submit) has finished; not from inside a task
+	void wait(){
+		unique_lock<mutex> lock(m);
+		finished.wait(lock, [&]{ return unfinished == 0; });
+	}
+
+	unsigned size() const{ return queues.size(); }
+	//the CPUs the workers are pinned to, as a sysfs-style list ("0-3,8"), or "os" when unpinned
+	string cpus() const{ return placement.empty() ? "os" : formatCpuList(placement) + (unpinned ? " (" + to_string(unpinned) + " not pinned)" : ""); }
+	bool pinned() const{ return !placement.empty(); }
+	uint64_t stealCount() const{ return steals; }
+
+	//index of the worker running the calling task, in [0, size()) - for per-worker state
+	unsigned workerIndex() const{ return (currentPool == this) ? currentWorker : 0; }
+
+	//per-worker time spent inside tasks since the last resetStats(); read after wait()
+	double busyMs(unsigned worker) const{ return stats[worker].busyNanos / 1e6; }
+	uint64_t tasksRun(unsigned worker) const{ return stats[worker].tasks; }
+	//the worker's counters since the last resetStats() (nothing valid unless counting events)
+	PerfCounts perfCounts(unsigned worker) const{ return counters.empty() ? PerfCounts() : counters[worker].read(); }
+	PerfCounts perfTotal() const{
+		PerfCounts total;
+		for(const PerfCounters& c : counters){total += c.read();}
+		return total;
+	}
+	void resetStats(){
+		for(WorkerStats& s : stats){ s.busyNanos = 0; s.tasks = 0; }
+		for(PerfCounters& c : counters){c.reset();}
+		steals = 0;
+	}
+};
+thread_local WorkStealingPool* WorkStealingPool::currentPool = nullptr;
+thread_local unsigned WorkStealingPool::currentWorker = 0;
+
+/* Parallel reduce
+	[a, b] is cut into tasks of grain numbers; map(low, high) computes a task's partial result, which
+	is folded into the accumulator of the worker that ran it - one accumulator per worker, each padded
+	to whole cache lines, so workers never write to a line another worker is writing
+	the worker accumulators are folded together once the pool is idle; tasks finish in no set order,
+	so reduce must be associative & commutative (sum, min, max, ...)	*/
+template<typename T>
+struct alignas(64) PaddedAccumulator {
+	T value;
+};
+
+template<typename T, typename Map, typename Reduce>
+T parallelReduce(WorkStealingPool& pool, uint64_t a, uint64_t b, uint64_t grain, T identity, Map map, Reduce reduce){
+	if(a > b){return identity;}
+	vector<PaddedAccumulator<T> > partial(pool.size(), PaddedAccumulator<T>{identity});
+	for(uint64_t low = a; ; low += grain){
+		uint64_t high = (b - low < grain) ? b : low + grain - 1;
+		pool.submit([low, high, &partial, &pool, &map, &reduce]{
+			T& mine = partial[pool.workerIndex()].value;
+			mine = reduce(mine, map(low, high));
+		});
+		if(high == b){break;}
+	}
+	pool.wait();
+	T total = identity;
+	for(const PaddedAccumulator<T>& p : partial){total = reduce(total, p.value);}
+	return total;
+}
+
+//countPrimes on a pool: [a, b] is cut into tasks of taskSize numbers, each counted by whichever worker gets to it
+//the tasks near b cost the most (trial division grows with n), & stealing evens that out
+const uint32_t primeTaskSize = 1 << 16;
+
+uint64_t countPrimesPool(WorkStealingPool& pool, uint32_t a, uint32_t b, PrimalityTest isPrime = primeTest, uint32_t taskSize = primeTaskSize){
+	return parallelReduce<uint64_t>(pool, a, b, taskSize, 0,
+		[isPrime](uint64_t low, uint64_t high){ return countPrimes(low, high, isPrime); },
+		[](uint64_t x, uint64_t y){ return x + y; });
+}
+
+#if defined(__cpp_impl_coroutine)
+/* Coroutine tasks (C++20; the rest of the program builds without them)
+	Task<T> is a lazy coroutine returning a T: nothing runs until it is awaited, & awaiting it
+	suspends the awaiter until the task's co_return hands the value back - no thread, no out-pointer
+	CoroutineScheduler::schedule() moves the awaiting coroutine onto a worker of an existing pool, so
+	starting a parallel stage costs one queued task, not an OS thread
+	whenAll(tasks) starts every task at once & resumes its awaiter with all their values, in order
+	syncWait(task) runs a task from ordinary code, blocking until it is done
+	exceptions are not carried across tasks: one escaping a task ends the program	*/
+template<typename T>
+class Task {
+public:
+	struct promise_type {
+		T value{};
+		coroutine_handle<> continuation;	//the coroutine awaiting this one
+
+		Task get_return_object(){ return Task(coroutine_handle<promise_type>::from_promise(*this)); }
+		suspend_always initial_suspend() noexcept{ return {}; }	//lazy: starts when awaited
+		struct FinalAwaiter {	//hand control straight to the awaiter (symmetric transfer, no stack growth)
+			bool await_ready() noexcept{ return false; }
+			coroutine_handle<> await_suspend(coroutine_handle<promise_type> h) noexcept{
+				coroutine_handle<> next = h.promise().continuation;
+				return next ? next : noop_coroutine();
+			}
+			void await_resume() noexcept{}
+		};
+		FinalAwaiter final_suspend() noexcept{ return {}; }
+		void return_value(T v){ value = move(v); }
+		void unhandled_exception(){ terminate(); }
+	};
+
+	Task(Task&& o) noexcept : h(o.h){ o.h = nullptr; }
+	~Task(){ if(h){h.destroy();} }
+	Task(const Task&) = delete;
+	Task& operator =(const Task&) = delete;
+
+	bool await_ready() const noexcept{ return false; }
+	coroutine_handle<> await_suspend(coroutine_handle<> awaiting){
+		h.promise().continuation = awaiting;
+		return h;	//start the task on this thread, right now
+	}
+	T await_resume(){ return move(h.promise().value); }
+
+private:
+	coroutine_handle<promise_type> h;
+	explicit Task(coroutine_handle<promise_type> handle) : h(handle){}
+};
+
+//a coroutine that starts at once & frees itself when it ends - the glue of whenAll & syncWait
+struct DetachedCoroutine {
+	struct promise_type {
+		DetachedCoroutine get_return_object(){ return {}; }
+		suspend_never initial_suspend() noexcept{ return {}; }
+		suspend_never final_suspend() noexcept{ return {}; }
+		void return_void(){}
+		void unhandled_exception(){ terminate(); }
+	};
+};
+
+class CoroutineScheduler {
+private:
+	WorkStealingPool& pool;
+
+public:
+	CoroutineScheduler(WorkStealingPool& workers) : pool(workers){}
+
+	struct ScheduleAwaiter {
+		WorkStealingPool& pool;
+		bool await_ready() const noexcept{ return false; }
+		void await_suspend(coroutine_handle<> h){ pool.submit([h]{ h.resume(); }); }
+		void await_resume() const noexcept{}
+	};
+	//co_await schedule(): continue on a pool worker
+	ScheduleAwaiter schedule(){ return ScheduleAwaiter{pool}; }
+	unsigned size() const{ return pool.size(); }
+};
+
+//fan-in point of whenAll: one count for each child plus one for the launcher, so the parent
+//is resumed exactly once - by the last child to finish, or by the launcher if they all beat it
+struct WhenAllLatch {
+	atomic<size_t> remaining;
+	coroutine_handle<> parent;
+	bool arrive(){ return remaining.fetch_sub(1) == 1; }
+};
+
+template<typename T>
+DetachedCoroutine whenAllChild(Task<T>& task, T& result, WhenAllLatch& latch){
+	result = co_await task;
+	if(latch.arrive()){latch.parent.resume();}
+}
+
+template<typename T>
+struct WhenAllAwaiter {
+	vector<Task<T> >& tasks;
+	vector<T>& results;
+	WhenAllLatch latch;
+
+	bool await_ready() const noexcept{ return tasks.empty(); }
+	bool await_suspend(coroutine_handle<> parent){
+		latch.parent = parent;
+		for(size_t i = 0; i < tasks.size(); i++){whenAllChild(tasks[i], results[i], latch);}	//each runs until it first suspends
+		return !latch.arrive();	//false: every child already finished - carry straight on
+	}
+	void await_resume() const noexcept{}
+};
+
+template<typename T>
+Task<vector<T> > whenAll(vector<Task<T> > tasks){
+	vector<T> results(tasks.size());
+	co_await WhenAllAwaiter<T>{tasks, results, WhenAllLatch{{tasks.size() + 1}, nullptr}};
+	co_return results;
+}
+
+struct SyncWaitFlag {
+	mutex m;
+	condition_variable done;
+	bool finished = false;
+};
+
+template<typename T>
+DetachedCoroutine syncWaitBody(Task<T>& task, T& result, SyncWaitFlag& flag){
+	result = co_await task;
+	lock_guard<mutex> lock(flag.m);
+	flag.finished = true;
+	flag.done.notify_one();
+}
+
+template<typename T>
+T syncWait(Task<T> task){
+	T result{};
+	SyncWaitFlag flag;
+	syncWaitBody(task, result, flag);
+	unique_lock<mutex> lock(flag.m);
+	flag.done.wait(lock, [&]{ return flag.finished; });
+	return result;
+}
+
+//one subrange, counted on whichever worker the scheduler hands it to
+Task<uint64_t> countPrimesTask(CoroutineScheduler& scheduler, uint32_t a, uint32_t b, PrimalityTest isPrime){
+	co_await scheduler.schedule();
+	co_return countPrimes(a, b, isPrime);
+}
+
+//countPrimes as awaited subranges: fan out one task per subrange, fan back in, add up
+Task<uint64_t> countPrimesCoroutine(CoroutineScheduler& scheduler, uint32_t a, uint32_t b, PrimalityTest isPrime = primeTest, uint32_t taskSize = primeTaskSize){
+	vector<Task<uint64_t> > parts;
+	for(uint64_t low = a; low <= b; low += taskSize){parts.push_back(countPrimesTask(scheduler, low, min<uint64_t>(b, low + taskSize - 1), isPrime));}
+	uint64_t total = 0;
+	for(uint64_t c : co_await whenAll(move(parts))){total += c;}
+	co_return total;
+}
+
+//two parallel stages composed: the same range by trial division & by sieve, at once, as one task
+Task<uint64_t> sieveCountTask(CoroutineScheduler& scheduler, uint64_t a, uint64_t b){
+	co_await scheduler.schedule();
+	co_return countPrimesSieve(a, b);
+}
+Task<vector<uint64_t> > countBothWays(CoroutineScheduler& scheduler, uint32_t a, uint32_t b){
+	vector<Task<uint64_t> > stages;
+	stages.push_back(countPrimesCoroutine(scheduler, a, b));
+	stages.push_back(sieveCountTask(scheduler, a, b));
+	co_return co_await whenAll(move(stages));
+}
+#endif
+
+/* Primality backends on random inputs
+	times primeTest & millerRabin on the same pseudo-random numbers & checks that they agree
+	trial division on 64-bit inputs can take seconds per prime, so it only gets as many inputs as fit in budgetMs	*/
+struct PrimalityTiming {
+	uint64_t tested = 0, primes = 0, disagreements = 0;
+	double trialNs = 0, millerRabinNs = 0;	//per input
+};
+
+PrimalityTiming timePrimality(unsigned bits, uint64_t inputs, double budgetMs, uint64_t seed = 1){
+	mt19937_64 rng(seed);
+	vector<uint64_t> values(inputs);
+	for(uint64_t& v : values){v = (bits >= 64) ? rng() : rng() >> (64 - bits);}
+
+	PrimalityTiming t;
+	vector<char> verdict(inputs);
+	std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now();
+	for(uint64_t i = 0; i < inputs; i++){verdict[i] = millerRabin(values[i]);}
+	std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();
+	t.millerRabinNs = std::chrono::duration_cast<std::chrono::duration<double, nano> >(b-a).count() / inputs;
+
+	a = std::chrono::steady_clock::now();
+	for(std::chrono::steady_clock::time_point now = a; t.tested < inputs; t.tested++){
+		if(std::chrono::duration_cast<std::chrono::duration<double, milli> >(now-a).count() > budgetMs){break;}
+		bool prime = primeTest(values[t.tested]);
+		t.primes += prime;
+		t.disagreements += (prime != bool(verdict[t.tested]));
+		now = std::chrono::steady_clock::now();
+	}
+	b = std::chrono::steady_clock::now();
+	t.trialNs = t.tested ? std::chrono::duration_cast<std::chrono::duration<double, nano> >(b-a).count() / t.tested : 0;
+	return t;
+}
+
+/* Scaling benchmark (--scale)
+	sweeps every engine over every range size & thread count, repeating each run, & prints one
+	row per (engine, n, threads): CSV by default, or one JSON object per line with --json
+		median_ms, stddev_ms, min_ms	wall time over the repeats
+		speedup, efficiency				median 1-thread time / median time, & speedup / threads
+		busy_mean_ms, busy_max_ms		time each worker spent inside tasks (mean & max over workers) - wall
+										time, so with more threads than cores it includes time preempted
+		imbalance						busy_max / busy_mean, median over the repeats - 1.0 is perfect
+		steals							tasks stolen, median over the repeats
+		cpus							CPUs the workers were pinned to (--pin), or os
+	with --perf, counter columns follow: cycles, instructions, ipc, branch_misses, l1d_misses, llc_misses,
+	task_clock_ms, context_switches, migrations - summed over the workers, median over the repeats;
+	empty (CSV) or null (JSON) where a counter is unavailable
+	one pool per thread count serves all its repeats, so thread start-up is not timed
+	each engine & size is run once untimed first, so one-time setup (Meissel-Lehmer's phi table, the
+	trial-division & presieve tables) is not charged to the 1-thread base of speedup
+	the 1-thread row is always measured, as the base of speedup	*/
+struct ScalingConfig {
+	vector<unsigned> threads;
+	vector<uint64_t> sizes;
+	unsigned repeats = 5;
+	bool json = false;
+	Placement placement;	//--pin: where each pool's workers run
+	bool perf = false;		//--perf: add hardware counter columns
+};
+
+//an engine counts the primes in [1, n] on a pool; maxN is the largest n it accepts
+struct CountingEngine {
+	const char* name;
+	function<uint64_t(WorkStealingPool&, uint64_t)> count;
+	uint64_t maxN;
+};
+
+//a whole command-line argument as a decimal number; false for anything else (empty, signs, trailing text, > 2^64 - 1)
+bool parseNumber(const char* text, uint64_t& value){
+	if(!isdigit(static_cast<unsigned char>(*text))){return false;}
+	char* end;
+	errno = 0;
+	value = strtoull(text, &end, 10);
+	return *end == '\0' && errno != ERANGE;
+}
+
+//comma-separated list; numbers may be written as 1e7
+vector<uint64_t> parseList(const char* text){
+	vector<uint64_t> values;
+	for(const char* p = text; *p;){
+		char* end;
+		values.push_back(strtod(p, &end));
+		if(end == p){break;}
+		p = (*end == ',') ? end + 1 : end;
+	}
+	return values;
+}
+
+double median(vector<double> v){
+	sort(v.begin(), v.end());
+	size_t h = v.size() / 2;
+	return (v.size() % 2) ? v[h] : (v[h - 1] + v[h]) / 2;
+}
+
+double stddev(const vector<double>& v){
+	double mean = 0, squares = 0;
+	for(double x : v){mean += x;}
+	mean /= v.size();
+	for(double x : v){squares += (x - mean) * (x - mean);}
+	return v.size() > 1 ? sqrt(squares / (v.size() - 1)) : 0;
+}
+
+void runScaling(const ScalingConfig& cfg, const vector<CountingEngine>& engines){
+	vector<unsigned> threadCounts = cfg.threads;
+	if(find(threadCounts.begin(), threadCounts.end(), 1u) == threadCounts.end()){threadCounts.insert(threadCounts.begin(), 1);}
+	sort(threadCounts.begin(), threadCounts.end());
+
+	if(!cfg.json){
+		cout << "engine,n,threads,repeats,count,median_ms,stddev_ms,min_ms,speedup,efficiency,busy_mean_ms,busy_max_ms,imbalance,steals,cpus"
+			<< (cfg.perf ? ",cycles,instructions,ipc,branch_misses,l1d_misses,llc_misses,task_clock_ms,context_switches,migrations" : "") << "\n";
+	}
+	for(const CountingEngine& engine : engines){
+		for(uint64_t n : cfg.sizes){
+			if(n > engine.maxN){continue;}
+			{	//warm-up, untimed: the first call builds whatever the engine sets up lazily
+				WorkStealingPool pool(threadCounts.back(), cfg.placement.cpusFor(threadCounts.back()));
+				engine.count(pool, n);
+			}
+			double baseMs = 0;
+			for(unsigned threads : threadCounts){
+				WorkStealingPool pool(threads, cfg.placement.cpusFor(threads), cfg.perf);
+				vector<double> wall, busyMean, busyMax, imbalance, steals;
+				vector<PerfCounts> perf;
+				uint64_t count = 0;
+				for(unsigned r = 0; r < cfg.repeats; r++){
+					pool.resetStats();
+					std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
+					count = engine.count(pool, n);
+					std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+					wall.push_back(std::chrono::duration_cast<std::chrono::duration<double, milli> >(b-a).count());
+
+					double sum = 0, most = 0;
+					for(unsigned w = 0; w < threads; w++){ sum += pool.busyMs(w); most = max(most, pool.busyMs(w)); }
+					busyMean.push_back(sum / threads);
+					busyMax.push_back(most);
+					imbalance.push_back(sum > 0 ? most / (sum / threads) : 1);
+					steals.push_back(pool.stealCount());
+					PerfCounts total;
+					for(unsigned w = 0; w < threads; w++){total += pool.perfCounts(w);}
+					perf.push_back(total);
+				}
+				double med = median(wall);
+				if(threads == 1){baseMs = med;}
+				double speedup = baseMs / med;
+				char row[512];
+				if(cfg.json){
+					snprintf(row, sizeof(row), "{\"engine\": \"%s\", \"n\": %llu, \"threads\": %u, \"repeats\": %u, \"count\": %llu, "
+						"\"median_ms\": %.3f, \"stddev_ms\": %.3f, \"min_ms\": %.3f, \"speedup\": %.3f, \"efficiency\": %.3f, "
+						"\"busy_mean_ms\": %.3f, \"busy_max_ms\": %.3f, \"imbalance\": %.3f, \"steals\": %.0f, \"cpus\": \"%s\"}\n",
+						engine.name, (unsigned long long)n, threads, cfg.repeats, (unsigned long long)count,
+						med, stddev(wall), *min_element(wall.begin(), wall.end()), speedup, speedup / threads,
+						median(busyMean), median(busyMax), median(imbalance), median(steals), pool.cpus().c_str());
+				}
+				else{
+					snprintf(row, sizeof(row), "%s,%llu,%u,%u,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.0f,\"%s\"\n",
+						engine.name, (unsigned long long)n, threads, cfg.repeats, (unsigned long long)count,
+						med, stddev(wall), *min_element(wall.begin(), wall.end()), speedup, speedup / threads,
+						median(busyMean), median(busyMax), median(imbalance), median(steals), pool.cpus().c_str());
+				}
+				if(cfg.perf){	//append the counter columns, before the newline (& closing brace)
+					string columns;
+					const char* names[] = {"cycles", "instructions", "ipc", "branch_misses", "l1d_misses", "llc_misses", "task_clock_ms", "context_switches", "migrations"};
+					const PerfEvent events[] = {perfCycles, perfInstructions, perfEventCount, perfBranchMisses, perfL1dMisses, perfLlcMisses, perfTaskClock, perfContextSwitches, perfMigrations};
+					for(int i = 0; i < 9; i++){
+						bool ipc = (events[i] == perfEventCount);
+						bool valid = ipc ? perf[0].has(perfCycles) && perf[0].has(perfInstructions) : perf[0].has(events[i]);
+						vector<double> v;
+						for(const PerfCounts& c : perf){ v.push_back(ipc ? c[perfInstructions] / max(1.0, c[perfCycles]) : events[i] == perfTaskClock ? c[events[i]] / 1e6 : c[events[i]]); }
+						char value[64] = "";
+						if(valid){snprintf(value, sizeof(value), (ipc || events[i] == perfTaskClock) ? "%.3f" : "%.0f", median(v));}
+						if(cfg.json){columns += string(", \"") + names[i] + "\": " + (valid ? value : "null");}
+						else{columns += string(",") + value;}
+					}
+					string line = row;
+					line.insert(line.size() - (cfg.json ? 2 : 1), columns);
+					cout << line << flush;
+				}
+				else{cout << row << flush;}	//rows appear as they finish - long sweeps can be watched
+			}
+		}
+	}
+}
+
+/* Parallel segmented sieve
+	the sieving primes up to sqrt(b) are computed once & shared, read-only, by every worker
+	each worker keeps one SegmentedSieve - its segment buffer & multiples - & reuses it for every task it runs
+	[a, b] is cut into tasks of whole segments, several per thread so stealing can even out the load
+	counts are summed by parallelReduce: per-worker padded accumulators, no counter shared while sieving	*/
+uint64_t countPrimesSieveParallel(WorkStealingPool& pool, uint64_t a, uint64_t b){
+	if(a > b){return 0;}
+	vector<uint32_t> primes = sievingPrimes(isqrt(b));
+	vector<SegmentedSieve> sieves(pool.size(), SegmentedSieve(primes));
+
+	const uint64_t segmentSpan = 2 * sieveSegmentBits;	//numbers per segment
+	uint64_t segments = (b - a) / segmentSpan + 1;
+	uint64_t perTask = min<uint64_t>(64, max<uint64_t>(1, segments / (8 * pool.size())));	//>= 8 tasks per thread when the range allows
+	return parallelReduce<uint64_t>(pool, a, b, perTask * segmentSpan, 0,
+		[&](uint64_t low, uint64_t high){ return sieves[pool.workerIndex()].count(low, high); },
+		[](uint64_t x, uint64_t y){ return x + y; });
+}
+
+/* Meissel-Lehmer prime counting: pi(x) without looking at every number (--pi X)
+	pi(x) = phi(x, a) + a - 1 - P2(x, a), where a = pi(y) for some y >= cbrt(x)
+		phi(x, a)	how many n <= x have no prime factor among the first a primes
+		P2(x, a)	how many n <= x are the product of exactly two primes, both past the a-th:
+					the sum over primes y < p <= sqrt(x) of pi(x / p) - pi(p) + 1
+		with y >= cbrt(x) no n <= x has three such factors, so nothing else is needed
+	phi recurses: phi(x, a) = phi(x, a - 1) - phi(x / p_a, a - 1), & most branches stop early -
+		a <= 6: phi(x, a) is periodic mod 2*3*5*7*11*13 = 30030, read from a table
+		x < 2^16, a <= 54: read from a table too (7 MB, built once from smallPrimes)
+		x < p_(a+1)^2: the survivors are 1 & the primes in (p_a, x], so phi = pi(x) - a + 1
+		x < p_(a+1): only 1 survives
+	every pi() below x / y is read from a PiTable: one bit per odd number (sieved on the pool) & a
+	running count per 64-bit word, ~12 bytes per 128 numbers
+	on the pool: the table's segments, the top-level phi terms (one task each) & the P2 sum
+	y is cbrt(x), or larger if x^(2/3) would not fit the table's memory budget; work ~ x^(2/3)	*/
+class PiTable {
+private:
+	vector<uint64_t> primeBits;	//bit i of the table: 2i + 1 is prime
+	vector<uint32_t> before;	//primes (2 included) below each word
+	uint64_t top;
+
+public:
+	//every prime up to limit, sieved on the pool
+	PiTable(WorkStealingPool& pool, uint64_t limit) : primeBits(limit / 128 + 1), before(primeBits.size()), top(primeBits.size() * 128 - 1){
+		vector<uint32_t> sieving = sievingPrimes(isqrt(top));
+		vector<SegmentedSieve> sieves(pool.size(), SegmentedSieve(sieving));
+		const uint64_t segmentSpan = 2 * sieveSegmentBits;
+		for(uint64_t low = 0; low <= top; low += segmentSpan){
+			pool.submit([this, low, &sieves, &pool]{
+				uint64_t* out = primeBits.data() + low / 128;	//segments start on words of the table
+				size_t words = SegmentedSieve::segmentWords(low, top);
+				sieves[pool.workerIndex()].sieveAt(low, words, out);
+				for(size_t w = 0; w < words; w++){out[w] = ~out[w];}	//1 now marks a prime
+			});
+		}
+		pool.wait();
+		uint32_t running = 1;	//2
+		for(size_t w = 0; w < primeBits.size(); w++){
+			before[w] = running;
+			running += __builtin_popcountll(primeBits[w]);
+		}
+	}
+
+	uint64_t limit() const{ return top; }
+
+	//pi(n) for n <= limit()
+	uint64_t operator ()(uint64_t n) const{
+		if(n < 3){return n == 2;}
+		uint64_t i = (n - 1) / 2;	//bit of the largest odd number <= n
+		return before[i / 64] + __builtin_popcountll(primeBits[i / 64] & (~uint64_t(0) >> (63 - i % 64)));
+	}
+
+	//the primes up to n, ascending (2 first)
+	vector<uint32_t> primesUpTo(uint64_t n) const{
+		vector<uint32_t> primes;
+		if(n >= 2){primes.push_back(2);}
+		for(uint64_t w = 0; w * 128 <= n; w++){
+			for(uint64_t bits = primeBits[w]; bits; bits &= bits - 1){
+				uint64_t p = 128 * w + 1 + 2 * __builtin_ctzll(bits);
+				if(p > n){break;}
+				primes.push_back(p);
+			}
+		}
+		return primes;
+	}
+};
+
+//largest r with r^3 <= n
+uint64_t icbrt(uint64_t n){
+	uint64_t r = cbrt((double)n);
+	while(r && r * r * r > n){r--;}
+	while(r < 2642245 && (r + 1) * (r + 1) * (r + 1) <= n){r++;}	//2642245^3 is the last cube below 2^64
+	return r;
 }
 
+//the PiTable's budget: 2^32 numbers, ~400 MB; pi(x) for larger x^(2/3) trades table for phi recursion
+const uint64_t piTableMaxLimit = uint64_t(1) << 32;
+
+class MeisselLehmer {
+private:
+	static const size_t tinyA = 6;	//phi(x, a <= 6) from the 30030-periodic tables
+	const PiTable& pi;
+	vector<uint32_t> primes;		//primes[i] is the (i + 1)-th prime
+
+	//tiny[a][r] = phi(r, a) for r < 2*3*...*p_a, a <= 6
+	static const vector<vector<uint16_t> >& tinyTables(){
+		static const vector<vector<uint16_t> > tables = []{
+			vector<vector<uint16_t> > t(tinyA + 1);
+			const uint32_t small[] = {2, 3, 5, 7, 11, 13};
+			uint32_t period = 1;
+			for(size_t a = 0; a <= tinyA; a++){
+				if(a){period *= small[a - 1];}
+				t[a].resize(period);
+				for(uint32_t r = 0, survivors = 0; r < period; r++){
+					bool coprime = r > 0;
+					for(size_t i = 0; i < a && coprime; i++){coprime = r % small[i] != 0;}
+					t[a][r] = survivors += coprime;
+				}
+			}
+			return t;
+		}();
+		return tables;
+	}
+
+	//small[a][x] = phi(x, a) for x < 2^16 & a <= 54 - where most of the recursion ends up; larger a
+	//have p_(a+1)^2 > 2^16, so for such x the pi() shortcut applies instead
+	static const size_t smallPhiA = 54;	//pi(256)
+	static const vector<vector<uint16_t> >& smallTables(){
+		static const vector<vector<uint16_t> > tables = []{
+			vector<vector<uint16_t> > t(smallPhiA + 1, vector<uint16_t>(smallPrimeLimit));
+			for(uint32_t x = 0; x < smallPrimeLimit; x++){t[0][x] = x;}
+			for(size_t a = 1; a <= smallPhiA; a++){
+				for(uint32_t x = 0; x < smallPrimeLimit; x++){t[a][x] = t[a - 1][x] - t[a - 1][x / smallPrimes[a - 1]];}
+			}
+			return t;
+		}();
+		return tables;
+	}
+
+	static int64_t phiTiny(uint64_t x, size_t a){
+		const vector<uint16_t>& t = tinyTables()[a];
+		uint64_t period = t.size();
+		return int64_t(x / period) * t[period - 1] + t[x % period];
+	}
+
+public:
+	MeisselLehmer(const PiTable& table, uint64_t maxPrime) : pi(table), primes(table.primesUpTo(maxPrime)){}
+
+	//phi(x, a): n in [1, x] with no prime factor among the first a primes; a <= number of primes held
+	int64_t phi(uint64_t x, size_t a) const{
+		if(x < smallPrimeLimit && a <= smallPhiA){return smallTables()[a][x];}
+		if(a <= tinyA){return phiTiny(x, a);}
+		if(x < primes[a]){return x ? 1 : 0;}
+		if(x <= pi.limit() && x < uint64_t(primes[a]) * primes[a]){return int64_t(pi(x)) - int64_t(a) + 1;}
+		int64_t sum = phiTiny(x, tinyA);
+		for(size_t i = tinyA + 1; i <= a; i++){
+			uint64_t xi = x / primes[i - 1];
+			if(xi < primes[i - 1]){ sum -= a - i + 1; break; }	//this term & every later one is phi = 1
+			sum -= phi(xi, i - 1);
+		}
+		return sum;
+	}
+
+	//the top-level terms phi(x / p_i, i - 1) for i in [first, last], summed
+	int64_t phiTerms(uint64_t x, size_t first, size_t last) const{
+		int64_t sum = 0;
+		for(size_t i = first; i <= last; i++){sum += phi(x / primes[i - 1], i - 1);}
+		return sum;
+	}
+
+	uint32_t prime(size_t i) const{ return primes[i - 1]; }	//the i-th prime, from 1
+	size_t primeCount() const{ return primes.size(); }
+};
+
+//pi(x) by Meissel-Lehmer on the pool
+uint64_t primePi(WorkStealingPool& pool, uint64_t x){
+	if(x < 2){return 0;}
+	uint64_t y = icbrt(x);
+	uint64_t sqrtX = isqrt(x);
+	uint64_t tableLimit = max(max(x / y, sqrtX), uint64_t(1) << 16);
+	if(tableLimit > piTableMaxLimit){ tableLimit = max(sqrtX, piTableMaxLimit); y = x / tableLimit; }
+	PiTable pi(pool, tableLimit);
+	if(x <= pi.limit()){return pi(x);}
+	MeisselLehmer ml(pi, sqrtX);
+	size_t a = pi(y);
+
+	//phi(x, a) = phi(x, 6) - the sum over i in (6, a] of phi(x / p_i, i - 1), one task per term
+	int64_t phi = ml.phi(x, min<size_t>(a, 6));
+	if(a > 6){
+		phi -= parallelReduce<int64_t>(pool, 7, a, 1, 0,
+			[&](uint64_t first, uint64_t last){ return ml.phiTerms(x, first, last); },
+			[](int64_t s, int64_t t){ return s + t; });
+	}
+
+	//P2: pi(x / p) - pi(p) + 1 over the primes y < p <= sqrt(x); p_b has pi(p_b) = b
+	size_t last = pi(sqrtX);
+	int64_t p2 = 0;
+	if(last > a){
+		p2 = parallelReduce<int64_t>(pool, a + 1, last, 1024, 0,
+			[&](uint64_t first, uint64_t end){
+				int64_t s = 0;
+				for(uint64_t b = first; b <= end; b++){s += int64_t(pi(x / ml.prime(b))) - int64_t(b) + 1;}
+				return s;
+			},
+			[](int64_t s, int64_t t){ return s + t; });
+	}
+	return phi + int64_t(a) - 1 - p2;
+}
+
+//primes in [a, b] by pi(b) - pi(a - 1); pays ~b^(2/3) however narrow the range
+uint64_t countPrimesMeissel(WorkStealingPool& pool, uint64_t a, uint64_t b){
+	if(a > b || b < 2){return 0;}
+	return primePi(pool, b) - (a > 2 ? primePi(pool, a - 1) : 0);
+}
+
+//primes in [a, b] by whichever engine is cheaper: the sieve's work grows with b - a (~1ns per number),
+//pi(x)'s with x^(2/3) (~3ns per unit, on the test machine) - so narrow windows sieve & long ranges don't
+//engine, if given, is set to the name of the one used
+uint64_t countPrimesRange(WorkStealingPool& pool, uint64_t a, uint64_t b, const char** engine = nullptr){
+	double analytic = 3 * (pow(double(b), 2.0 / 3) + pow(double(a), 2.0 / 3));
+	bool sieve = a > b || b - a < analytic;
+	if(engine){*engine = sieve ? "Segmented Sieve" : "Meissel-Lehmer";}
+	return sieve ? countPrimesSieveParallel(pool, a, b) : countPrimesMeissel(pool, a, b);
+}
+
+/* Prime enumeration on the pool
+	visit(p) sees every prime in [a, b], ascending, on the calling thread, while the pool sieves ahead
+	segments are sieved straight into a ring of 2 buffers per worker; a buffer is handed back to the pool
+	for the segment one ring further on as soon as its primes have been visited - so memory stays at
+	the ring plus the sieving primes (& each worker's next multiples), however long the range;
+	those grow with sqrt(b), so b is at most sieveMaxLimit
+	visit should be quick: while it runs, the workers can only fill the rest of the ring	*/
+template<typename F>
+void forEachPrime(WorkStealingPool& pool, uint64_t a, uint64_t b, F visit){
+	if(a > b){return;}
+	if(a <= 2 && b >= 2){visit(uint64_t(2));}
+	vector<uint32_t> primes = sievingPrimes(isqrt(b));
+	vector<SegmentedSieve> sieves(pool.size(), SegmentedSieve(primes));
+
+	struct Slot {
+		vector<uint64_t> bits = vector<uint64_t>(sieveSegmentBits / 64);
+		uint64_t low = 0;
+		size_t words = 0;
+		bool ready = false;
+	};
+	const uint64_t segmentSpan = 2 * sieveSegmentBits;
+	uint64_t first = SegmentedSieve::firstSegment(a);
+	uint64_t segments = (b - first) / segmentSpan + 1;
+	vector<Slot> ring(2 * pool.size());
+	mutex m;
+	condition_variable sieved;
+
+	auto launch = [&](uint64_t i){
+		Slot& slot = ring[i % ring.size()];
+		slot.low = first + i * segmentSpan;
+		slot.words = SegmentedSieve::segmentWords(slot.low, b);
+		slot.ready = false;
+		pool.submit([&slot, &sieves, &pool, &m, &sieved]{
+			sieves[pool.workerIndex()].sieveAt(slot.low, slot.words, slot.bits.data());
+			lock_guard<mutex> lock(m);
+			slot.ready = true;
+			sieved.notify_all();
+		});
+	};
+	for(uint64_t i = 0; i < min<uint64_t>(ring.size(), segments); i++){launch(i);}
+	for(uint64_t i = 0; i < segments; i++){
+		Slot& slot = ring[i % ring.size()];
+		{
+			unique_lock<mutex> lock(m);
+			sieved.wait(lock, [&]{ return slot.ready; });
+		}
+		SegmentedSieve::forEachPrimeIn(slot.bits.data(), slot.low, slot.words, a, b, visit);
+		if(i + ring.size() < segments){launch(i + ring.size());}
+	}
+	pool.wait();
+}
+
+/* Prime files (--out)
+	[PrimeFileHeader][one varint per prime]
+	each prime is stored as its gap from the one before (the first, from 0), as a LEB128 varint:
+	7 bits per byte, low bits first, the top bit set on every byte but the last
+	below 10^12 nearly every gap is under 128, so a prime costs about one byte
+	the count is filled in when the writer is closed, so a file without one was not finished	*/
+struct PrimeFileHeader {
+	char magic[8];
+	uint64_t a, b;	//the range enumerated
+	uint64_t count;
+};
+const char primeFileMagic[8] = {'P','R','I','M','E','G','A','P'};
+
+class PrimeFileWriter {
+private:
+	FILE* file;
+	PrimeFileHeader header;
+	vector<uint8_t> buffer;
+	size_t used;
+	uint64_t previous;
+	static const size_t bufferBytes = 1 << 20;
+
+	bool flush(){
+		bool ok = fwrite(buffer.data(), 1, used, file) == used;
+		used = 0;
+		return ok;
+	}
+
+public:
+	PrimeFileWriter(const char* path, uint64_t a, uint64_t b) : file(fopen(path, "wb")), buffer(bufferBytes), used(0), previous(0){
+		memcpy(header.magic, primeFileMagic, sizeof(primeFileMagic));
+		header.a = a;
+		header.b = b;
+		header.count = 0;
+		if(file){fwrite(&header, sizeof(header), 1, file);}	//rewritten with the count by close()
+	}
+	~PrimeFileWriter(){ close(); }
+	PrimeFileWriter(const PrimeFileWriter&) = delete;
+	PrimeFileWriter& operator =(const PrimeFileWriter&) = delete;
+
+	bool isOpen() const{ return file != nullptr; }
+
+	void add(uint64_t p){
+		if(used + 10 > buffer.size()){flush();}	//a 64-bit varint is at most 10 bytes
+		uint64_t gap = p - previous;
+		previous = p;
+		for(; gap >= 0x80; gap >>= 7){buffer[used++] = uint8_t(gap) | 0x80;}
+		buffer[used++] = uint8_t(gap);
+		header.count++;
+	}
+
+	bool close(){
+		if(!file){return false;}
+		bool ok = flush() && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+		ok = (fclose(file) == 0) && ok;
+		file = nullptr;
+		return ok;
+	}
+};
+
+//visit(p) for every prime stored in a prime file, ascending; false if the file is missing, unfinished or corrupt
+template<typename F>
+bool readPrimeFile(const char* path, F visit){
+	FILE* file = fopen(path, "rb");
+	if(!file){return false;}
+	PrimeFileHeader header;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, primeFileMagic, sizeof(primeFileMagic)) == 0;
+	vector<uint8_t> buffer(1 << 20);
+	uint64_t p = 0, gap = 0, read = 0;
+	unsigned shift = 0;
+	for(size_t n; ok && (n = fread(buffer.data(), 1, buffer.size(), file)) > 0;){
+		for(size_t i = 0; i < n; i++){
+			gap |= uint64_t(buffer[i] & 0x7F) << shift;
+			if(buffer[i] & 0x80){ shift += 7; continue; }
+			p += gap;
+			visit(p);
+			read++;
+			gap = 0;
+			shift = 0;
+		}
+	}
+	fclose(file);
+	return ok && shift == 0 && read == header.count;
+}
+
+/* False sharing, measured (--false-sharing)
+	every worker adds to its own counter, many times over: once with the counters packed side by side
+	(8 to a cache line, as separate uint64_t variables on the stack were), once padded like parallelReduce's
+	with the counters packed, each write steals the line from the other cores, so time per add grows with threads;
+	padded, it stays flat - on a single core both are the same; with cpus given, thread t is pinned to cpus[t]	*/
+template<typename Counter>
+double timeCounterAdds(unsigned threads, uint64_t adds, const vector<unsigned>& cpus = {}){
+	vector<Counter> counters(threads);
+	vector<thread> workers;
+	std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
+	for(unsigned t = 0; t < threads; t++){
+		workers.emplace_back([&counters, &cpus, t, adds]{
+			if(t < cpus.size()){pinCurrentThread(cpus[t]);}
+			volatile uint64_t& mine = counters[t].value;	//volatile: every add really goes to memory
+			for(uint64_t i = 0; i < adds; i++){mine = mine + 1;}
+		});
+	}
+	for(thread& w : workers){w.join();}
+	std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+	return std::chrono::duration_cast<std::chrono::duration<double, nano> >(b-a).count() / adds;	//ns per add, per thread
+}
+struct PackedCounter { uint64_t value; };
+
 int main(int argc, char *argv[]){
+	uint64_t sieveOnly = 0;	//--sieve N: skip the trial-division runs
+	uint64_t piOnly = 0;	//--pi N: pi(N) by Meissel-Lehmer alone
+	bool countRange = false;	//--count A B: primes in [A, B] by the engine that suits the range
+	uint64_t countFrom = 0, countTo = 0;
+	uint64_t single = 0;	//--is-prime N: test one number & exit
+	bool singleGiven = false;
+	PrimalityTest test = primeTest;
+	unsigned maxThreads = thread::hardware_concurrency();
+	bool scale = false;		//--scale: run the scaling sweep instead
+	bool falseSharing = false;	//--false-sharing: time packed vs padded counters instead
+	bool enumerate = false;		//--enumerate A B: stream the primes of [A, B] instead
+	uint64_t enumerateFrom = 0, enumerateTo = 0;
+	const char* primeFile = nullptr;	//--out FILE: ...into a delta-encoded prime file
+	ScalingConfig scaling;
+	const char* threadList = nullptr;
+	Placement placement;	//--pin compact|spread: pin pool workers to CPUs
+	bool showTopology = false;	//--topology: print the CPU topology & exit
+	bool perf = false;		//--perf: report hardware counters per worker next to the pool timings
+	auto number = [&](int& i, uint64_t& value){ return i + 1 < argc && parseNumber(argv[++i], value); };	//the next argument
+	for(int i = 1; i < argc; i++){
+		string arg = argv[i];
+		if(arg == "--sieve"){
+			if(!number(i, sieveOnly) || sieveOnly == 0){ cerr << "--sieve takes N >= 1: counts the primes up to N\n"; return 1; }
+		}
+		else if(arg == "--pi"){
+			if(!number(i, piOnly) || piOnly == 0){ cerr << "--pi takes N >= 1: pi(N) by Meissel-Lehmer\n"; return 1; }
+		}
+		else if(arg == "--count"){
+			if(!number(i, countFrom) || !number(i, countTo)){ cerr << "--count takes A B: counts the primes in [A, B]\n"; return 1; }
+			countRange = true;
+		}
+		else if(arg == "--is-prime"){
+			if(!number(i, single)){ cerr << "--is-prime takes N: any 64-bit number\n"; return 1; }
+			singleGiven = true;
+		}
+		else if(arg == "--miller-rabin"){test = millerRabin;}
+		else if(arg == "--batch"){test = primeTestBatched;}
+		else if(arg == "--wheel"){test = primeTestWheel;}
+		else if(arg == "--threads" && i + 1 < argc){maxThreads = atoi(argv[++i]);}
+		else if(arg == "--scale"){scale = true;}
+		else if(arg == "--false-sharing"){falseSharing = true;}
+		else if(arg == "--enumerate"){
+			if(!number(i, enumerateFrom) || !number(i, enumerateTo)){ cerr << "--enumerate takes A B: the primes in [A, B]\n"; return 1; }
+			enumerate = true;
+		}
+		else if(arg == "--out" && i + 1 < argc){primeFile = argv[++i];}
+		else if(arg == "--scale-threads" && i + 1 < argc){threadList = argv[++i];}
+		else if(arg == "--scale-sizes" && i + 1 < argc){scaling.sizes = parseList(argv[++i]);}
+		else if(arg == "--repeat" && i + 1 < argc){scaling.repeats = max(1, atoi(argv[++i]));}
+		else if(arg == "--json"){scaling.json = true;}
+		else if(arg == "--pin" && i + 1 < argc){
+			string policy = argv[++i];
+			if(policy == "compact"){placement.policy = PlacementPolicy::compact;}
+			else if(policy == "spread"){placement.policy = PlacementPolicy::spread;}
+			else if(policy != "os"){ cerr << "--pin takes compact, spread or os\n"; return 1; }
+		}
+		else if(arg == "--topology"){showTopology = true;}
+		else if(arg == "--perf"){ perf = true; scaling.perf = true; }
+	}
+	if(max({sieveOnly, piOnly, countRange ? countTo : 0, enumerate ? enumerateTo : 0}) > sieveMaxLimit){
+		cerr << "--sieve, --pi, --count & --enumerate go up to " << sieveMaxLimit << " (every prime up to the square root is held in memory)\n";
+		return 1;
+	}
+	if(maxThreads == 0){maxThreads = 1;}	//hardware_concurrency() may not know
+	placement.topology = readTopology();
+	scaling.placement = placement;
+
+	//////////////////////////////////////////////////////////////////////////////   Scaling sweep (machine-readable, no header)
+	if(scale){
+		if(threadList){ for(uint64_t t : parseList(threadList)){ if(t){scaling.threads.push_back(t);} } }
+		else{ for(unsigned t = 1; ; t = min(2 * t, maxThreads)){ scaling.threads.push_back(t); if(t == maxThreads){break;} } }
+		if(scaling.sizes.empty()){scaling.sizes = {1000000, 10000000};}
+		vector<CountingEngine> engines = {
+			{"trial-division", [](WorkStealingPool& pool, uint64_t n){ return countPrimesPool(pool, 1, n, primeTest); }, UINT32_MAX},
+			{"miller-rabin", [](WorkStealingPool& pool, uint64_t n){ return countPrimesPool(pool, 1, n, millerRabin); }, UINT32_MAX},
+			{"batch-trial-division", [](WorkStealingPool& pool, uint64_t n){ return countPrimesPool(pool, 1, n, primeTestBatched); }, UINT32_MAX},
+			{"wheel-trial-division", [](WorkStealingPool& pool, uint64_t n){ return countPrimesPool(pool, 1, n, primeTestWheel); }, UINT32_MAX},
+			{"sieve", [](WorkStealingPool& pool, uint64_t n){ return countPrimesSieveParallel(pool, 1, n); }, sieveMaxLimit},
+			{"meissel-lehmer", [](WorkStealingPool& pool, uint64_t n){ return countPrimesMeissel(pool, 1, n); }, sieveMaxLimit},
+		};
+		runScaling(scaling, engines);
+		return 0;
+	}
+
 	//////////////////////////////////////////////////////////////////////////////   Pretty Header
 	textcolor('g');
 	cout << "\n\n_________________________________________________________________________________\n\n";
@@ -75,56 +1928,263 @@ int main(int argc, char *argv[]){
 	cout << "https://github.com/stephen-opet\n\n\n";
 	textcolor('w');
 
+	/////////////////////////////////////////////////////////////////////////////	Topology & placement
+	if(showTopology || placement.policy != PlacementPolicy::os){
+		const Topology& topo = placement.topology;
+		cout << "\tTopology: " << topo.nodes << " NUMA node(s), " << topo.packages << " socket(s), " << topo.cores << " core(s), "
+			<< topo.cpus.size() << " logical CPU(s) usable; workers placed: " << placementName(placement.policy) << "\n";
+		vector<pair<unsigned, unsigned> > groups;	//(node, socket)
+		for(const LogicalCpu& l : topo.cpus){groups.emplace_back(l.node, l.package);}
+		sort(groups.begin(), groups.end());
+		groups.erase(unique(groups.begin(), groups.end()), groups.end());
+		for(const pair<unsigned, unsigned>& g : groups){
+			vector<unsigned> cpus;
+			for(const LogicalCpu& l : topo.cpus){ if(l.node == g.first && l.package == g.second){cpus.push_back(l.cpu);} }
+			cout << "\t\tnode " << g.first << ", socket " << g.second << ": cpus " << formatCpuList(cpus) << "\n";
+		}
+		cout << '\n';
+		if(showTopology){return endProgram(0);}
+	}
+
+	if(perf){
+		string why = perfUnavailable();
+		cout << "\tPerformance counters: " << (why.empty() ? "hardware & software" : "software only - hardware counters unavailable: " + why) << "\n\n";
+	}
+
+	/////////////////////////////////////////////////////////////////////////////	Enumerate primes (streamed)
+	if(enumerate){
+		WorkStealingPool pool(maxThreads, placement.cpusFor(maxThreads), perf);
+		unique_ptr<PrimeFileWriter> out;
+		if(primeFile){
+			out.reset(new PrimeFileWriter(primeFile, enumerateFrom, enumerateTo));
+			if(!out->isOpen()){ cout << "\tUnable to open " << primeFile << "\n"; return endProgram(1); }
+		}
+		uint64_t count = 0, largest = 0;
+		std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
+		forEachPrime(pool, enumerateFrom, enumerateTo, [&](uint64_t p){
+			count++;
+			largest = p;
+			if(out){out->add(p);}
+		});
+		if(out && !out->close()){ cout << "\tError writing " << primeFile << "\n"; return endProgram(1); }
+		std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+		double seconds = std::chrono::duration_cast<std::chrono::duration<double> >(b-a).count();
+
+		cout << "\tPrimes in " << enumerateFrom << " - " << enumerateTo << ": " << count << " (largest " << largest << ")\n";
+		cout << "\t" << maxThreads << "-Thread Enumeration Duration (ms): " << seconds * 1000 << "ms  (" << count / seconds / 1e6 << " million primes per second"
+			<< (pool.pinned() ? ", cpus " + pool.cpus() : "") << ")\n";
+		if(perf){cout << "\t\tall workers: " << describePerf(pool.perfTotal(), enumerateTo >= enumerateFrom ? enumerateTo - enumerateFrom + 1 : 0) << '\n';}
+		if(primeFile){	//read the file back as a downstream job would
+			uint64_t stored = 0;
+			bool ok = readPrimeFile(primeFile, [&](uint64_t){ stored++; });
+			FILE* f = fopen(primeFile, "rb");
+			fseek(f, 0, SEEK_END);
+			long bytes = ftell(f);
+			fclose(f);
+			cout << "\tWrote " << primeFile << ": " << bytes << " bytes, " << (count ? double(bytes - sizeof(PrimeFileHeader)) / count : 0)
+				<< " bytes per prime; read back " << stored << " primes" << (ok && stored == count ? "" : "  (MISMATCH)") << "\n";
+		}
+		cout << '\n';
+		return endProgram(0);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////	False sharing, measured
+	if(falseSharing){
+		const uint64_t adds = 100000000;
+		for(unsigned threads = 1; ; threads = min(2 * threads, maxThreads)){
+			cout << "\t" << threads << " thread(s), " << adds << " adds each:  packed counters " << timeCounterAdds<PackedCounter>(threads, adds, placement.cpusFor(threads))
+				<< "ns per add,  padded counters " << timeCounterAdds<PaddedAccumulator<uint64_t> >(threads, adds, placement.cpusFor(threads)) << "ns per add"
+				<< (placement.policy == PlacementPolicy::os ? "" : "  (cpus " + formatCpuList(placement.cpusFor(threads)) + ")") << "\n";
+			if(threads == maxThreads){break;}
+		}
+		cout << '\n';
+		return endProgram(0);
+	}
+
 	/////////////////////////////////////////////////////////////////////////////	Declare Variables
 	const uint32_t n = 10000000;	//krug's default value (100M) takes ~187 seconds on my PC
 									//reduce by a factor of 10-100 for mere mortal PCs
-	uint64_t count_1thread = 0;
-	uint64_t count_2threadA = 0;
-	uint64_t count_2threadB = 0;
-	uint64_t count_4threadA = 0;
-	uint64_t count_4threadB = 0;
-	uint64_t count_4threadC = 0;
-	uint64_t count_4threadD = 0;
 
+	if(singleGiven){
+		std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
+		bool prime = millerRabin(single);
+		std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+		cout << "\t" << single << (prime ? " is prime" : " is not prime") << "  (Miller-Rabin, "
+			<< std::chrono::duration_cast<std::chrono::duration<double, micro> >(b-a).count() << "us)\n\n";
+		return endProgram(0);
+	}
+
+	if(sieveOnly){
+		WorkStealingPool pool(maxThreads, placement.cpusFor(maxThreads), perf);
+		std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count = countPrimesSieveParallel(pool, 1, sieveOnly);
+		std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+		cout << "\tRange for Prime Numbers: 1 - " << sieveOnly << "\n\n"; 
+		cout << "\tTotal Number of Prime Numbers:  " << count << '\n';
+		cout << "\t" << maxThreads << "-Thread Segmented Sieve Duration (ms): " << std::chrono::duration_cast<std::chrono::duration<double> >(b-a).count()*1000 << "ms"
+			<< (pool.pinned() ? "  (cpus " + pool.cpus() + ")" : "") << "\n";
+		if(perf){cout << "\t\tall workers: " << describePerf(pool.perfTotal(), sieveOnly) << '\n';}
+		cout << '\n';
+		return endProgram(0);
+	}
+
+	if(piOnly){
+		WorkStealingPool pool(maxThreads, placement.cpusFor(maxThreads), perf);
+		std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count = primePi(pool, piOnly);
+		std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+		cout << "\tRange for Prime Numbers: 1 - " << piOnly << "\n\n"; 
+		cout << "\tTotal Number of Prime Numbers:  " << count << '\n';
+		cout << "\t" << maxThreads << "-Thread Meissel-Lehmer Duration (ms): " << std::chrono::duration_cast<std::chrono::duration<double> >(b-a).count()*1000 << "ms"
+			<< (pool.pinned() ? "  (cpus " + pool.cpus() + ")" : "") << "\n";
+		if(perf){cout << "\t\tall workers: " << describePerf(pool.perfTotal(), piOnly) << '\n';}	//before the check below adds its own work
+		if(piOnly <= 10000000000ull){	//small enough to check against the sieve in seconds
+			uint64_t sieved = countPrimesSieveParallel(pool, 1, piOnly);
+			cout << "\tSegmented Sieve agrees:  " << (sieved == count ? "yes" : "NO - " + to_string(sieved)) << '\n';
+		}
+		cout << '\n';
+		return endProgram(0);
+	}
+
+	if(countRange){
+		WorkStealingPool pool(maxThreads, placement.cpusFor(maxThreads), perf);
+		const char* engine;
+		std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count = countPrimesRange(pool, countFrom, countTo, &engine);
+		std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+		cout << "\tRange for Prime Numbers: " << countFrom << " - " << countTo << "\n\n"; 
+		cout << "\tTotal Number of Prime Numbers:  " << count << '\n';
+		cout << "\t" << maxThreads << "-Thread " << engine << " Duration (ms): " << std::chrono::duration_cast<std::chrono::duration<double> >(b-a).count()*1000 << "ms\n";
+		if(perf){cout << "\t\tall workers: " << describePerf(pool.perfTotal(), countTo >= countFrom ? countTo - countFrom + 1 : 0) << '\n';}
+		cout << '\n';
+		return endProgram(0);
+	}
 
+	PerfCounters mainCounters;	//--perf: the single-thread run, counted on this thread
+	if(perf){mainCounters.open();}
 	std::chrono::steady_clock::time_point a = std::chrono::steady_clock::now(); //start timer 
-	countPrimes(1,  n, &count_1thread);
+	uint64_t count_1thread = countPrimes(1,  n, test);
 	std::chrono::steady_clock::time_point b = std::chrono::steady_clock::now();	//stop timer
+	PerfCounts single_counts = mainCounters.read();
 	double single_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(b-a).count()*1000;
 
 
 	cout << "\tRange for Prime Numbers: 1 - " << n << "\n\n"; 
 	cout << "\tTotal Number of Prime Numbers:  " << count_1thread << '\n';
-  	cout << "\tSingle-Thread Duration (ms): " << single_duration_ms << "ms" <<  "\n\n";
+  	cout << "\tSingle-Thread Duration (ms): " << single_duration_ms << "ms" <<  "\n";
+	if(perf){cout << "\t\t" << describePerf(single_counts, n) << '\n';}
+	cout << '\n';
 	
-	// now benchmark with 2 threads
-	std::chrono::steady_clock::time_point c = std::chrono::steady_clock::now(); //start timer 
-	thread t1( countPrimes, 1,  n/2, &count_2threadA);
-	thread t2( countPrimes, (n/2)+1, n, &count_2threadB);
-	t1.join();
-	t2.join();
-	std::chrono::steady_clock::time_point d = std::chrono::steady_clock::now();	//stop timer
-	double double_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(d-c).count()*1000;
-
-	cout << "\tTotal Number of Prime Numbers: " << count_2threadA + count_2threadB << '\n';
-	cout << "\tTwo-Thread Duration (ms):  " << double_duration_ms << "ms" << "\n\n";
-
-	// finally benchmark with 4 threads
-	//will only demonstrate improvement for systems running 4+ cores
-	std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now(); //start timer 
-	thread t41( countPrimes, 1,  n/4, &count_4threadA);
-	thread t42( countPrimes, (n/4)+1, n/2, &count_4threadB);
-	thread t43( countPrimes, (n/2)+1, 3*n/4, &count_4threadC);
-	thread t44( countPrimes, (3*n/4)+1, n, &count_4threadD);
-	t41.join();
-	t42.join();
-	t43.join();
-	t44.join();
-	std::chrono::steady_clock::time_point f = std::chrono::steady_clock::now();	//stop timer
-	double quad_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(f-e).count()*1000;
-
-	cout << "\tTotal Number of Prime Numbers: " << count_4threadA + count_4threadB + count_4threadC + count_4threadD << '\n';
-	cout << "\tFour-Thread Duration (ms):  " << quad_duration_ms << "ms" << "\n\n";
+	// now the same work on a work-stealing pool, doubling the threads up to maxThreads
+	for(unsigned threads = 1; ; threads = min(2 * threads, maxThreads)){
+		WorkStealingPool pool(threads, placement.cpusFor(threads), perf);
+		std::chrono::steady_clock::time_point c = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count_pool = countPrimesPool(pool, 1, n, test);
+		std::chrono::steady_clock::time_point d = std::chrono::steady_clock::now();	//stop timer
+		double pool_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(d-c).count()*1000;
+
+		cout << "\tTotal Number of Prime Numbers: " << count_pool << '\n';
+		cout << "\t" << threads << "-Thread Pool Duration (ms):  " << pool_duration_ms << "ms  (speedup " << single_duration_ms / pool_duration_ms
+			<< "x, " << pool.stealCount() << " tasks stolen" << (pool.pinned() ? ", cpus " + pool.cpus() : "") << ")\n";
+		if(perf){	//each worker's share, then the pool as a whole
+			PerfCounts total;
+			for(unsigned w = 0; w < threads; w++){
+				PerfCounts c = pool.perfCounts(w);
+				total += c;
+				if(threads > 1){cout << "\t\tworker " << w << ": " << describePerf(c, 0) << '\n';}
+			}
+			cout << "\t\t" << (threads > 1 ? "all workers: " : "") << describePerf(total, n) << '\n';
+		}
+		cout << '\n';
+		if(threads == maxThreads){break;}
+	}
+
+	// trial division again, but batched across SIMD lanes
+	{
+		const char* kernel;
+		batchKernel(&kernel);
+		std::chrono::steady_clock::time_point c = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count_batch = countPrimes(1, n, primeTestBatched);
+		std::chrono::steady_clock::time_point d = std::chrono::steady_clock::now();	//stop timer
+		double batch_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(d-c).count()*1000;
+
+		cout << "\tTotal Number of Prime Numbers: " << count_batch << (count_batch == count_1thread ? "" : "  (MISMATCH)") << '\n';
+		cout << "\tBatched Trial Division (" << kernel << ") Duration (ms):  " << batch_duration_ms << "ms" << "\n\n";
+	}
+
+	// trial division by the compile-time prime table, over wheel candidates only
+	for(uint32_t modulus : {30, 210}){
+		std::chrono::steady_clock::time_point c = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count_wheel = (modulus == 30) ? countPrimesWheel<30>(1, n) : countPrimesWheel<210>(1, n);
+		std::chrono::steady_clock::time_point d = std::chrono::steady_clock::now();	//stop timer
+		double wheel_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(d-c).count()*1000;
+
+		cout << "\tTotal Number of Prime Numbers: " << count_wheel << (count_wheel == count_1thread ? "" : "  (MISMATCH)") << '\n';
+		cout << "\tWheel (mod " << modulus << ") Trial Division Duration (ms):  " << wheel_duration_ms << "ms  ("
+			<< (modulus == 30 ? wheel<30>.spokes : wheel<210>.spokes) << " of every " << modulus << " numbers tested)\n\n";
+	}
+
+	// the same range by sieve, single thread
+	std::chrono::steady_clock::time_point g = std::chrono::steady_clock::now(); //start timer 
+	uint64_t count_sieve = countPrimesSieve(1, n);
+	std::chrono::steady_clock::time_point h = std::chrono::steady_clock::now();	//stop timer
+	double sieve_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(h-g).count()*1000;
+
+	cout << "\tTotal Number of Prime Numbers: " << count_sieve << (count_sieve == count_1thread ? "" : "  (MISMATCH)") << '\n';
+	cout << "\tSegmented Sieve Duration (ms):  " << sieve_duration_ms << "ms" << "\n\n";
+
+	// & by sieve on the pool
+	{
+		WorkStealingPool pool(maxThreads, placement.cpusFor(maxThreads));
+		std::chrono::steady_clock::time_point c = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count_parallel = countPrimesSieveParallel(pool, 1, n);
+		std::chrono::steady_clock::time_point d = std::chrono::steady_clock::now();	//stop timer
+		double parallel_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(d-c).count()*1000;
+
+		cout << "\tTotal Number of Prime Numbers: " << count_parallel << (count_parallel == count_1thread ? "" : "  (MISMATCH)") << '\n';
+		cout << "\t" << maxThreads << "-Thread Segmented Sieve Duration (ms):  " << parallel_duration_ms << "ms" << (pool.pinned() ? "  (cpus " + pool.cpus() + ")" : "") << "\n\n";
+	}
+
+	// & without sieving the range at all: pi(n) by Meissel-Lehmer
+	{
+		WorkStealingPool pool(maxThreads, placement.cpusFor(maxThreads));
+		std::chrono::steady_clock::time_point c = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count_pi = primePi(pool, n);
+		std::chrono::steady_clock::time_point d = std::chrono::steady_clock::now();	//stop timer
+		double pi_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(d-c).count()*1000;
+
+		cout << "\tTotal Number of Prime Numbers: " << count_pi << (count_pi == count_1thread ? "" : "  (MISMATCH)") << '\n';
+		cout << "\t" << maxThreads << "-Thread Meissel-Lehmer Duration (ms):  " << pi_duration_ms << "ms" << (pool.pinned() ? "  (cpus " + pool.cpus() + ")" : "") << "\n\n";
+	}
+
+#if defined(__cpp_impl_coroutine)
+	// the pool count again, written as coroutines: one pool for both runs, no thread started per stage
+	{
+		WorkStealingPool pool(maxThreads, placement.cpusFor(maxThreads));
+		CoroutineScheduler scheduler(pool);
+		std::chrono::steady_clock::time_point c = std::chrono::steady_clock::now(); //start timer 
+		uint64_t count_coroutine = syncWait(countPrimesCoroutine(scheduler, 1, n, test));
+		std::chrono::steady_clock::time_point d = std::chrono::steady_clock::now();	//stop timer
+		vector<uint64_t> both = syncWait(countBothWays(scheduler, 1, n));
+		std::chrono::steady_clock::time_point e = std::chrono::steady_clock::now();	//stop timer
+		double coroutine_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(d-c).count()*1000;
+		double both_duration_ms = std::chrono::duration_cast<std::chrono::duration<double> >(e-d).count()*1000;
+
+		cout << "\tTotal Number of Prime Numbers: " << count_coroutine << (count_coroutine == count_1thread ? "" : "  (MISMATCH)") << '\n';
+		cout << "\t" << maxThreads << "-Thread Coroutine Duration (ms):  " << coroutine_duration_ms << "ms" << (pool.pinned() ? "  (cpus " + pool.cpus() + ")" : "") << "\n";
+		cout << "\tTrial Division & Sieve as one Coroutine (ms):  " << both_duration_ms << "ms  ("
+			<< (both[0] == count_1thread && both[1] == count_1thread ? "both agree" : "MISMATCH") << ")\n\n";
+	}
+#endif
+
+	// trial division vs Miller-Rabin, one number at a time
+	for(unsigned bits : {32, 64}){
+		PrimalityTiming pt = timePrimality(bits, 100000, 2000);
+		cout << "\tRandom " << bits << "-bit inputs: Miller-Rabin " << pt.millerRabinNs << "ns per test; trial division "
+			<< pt.trialNs << "ns per test (" << pt.tested << " inputs, " << pt.primes << " prime"
+			<< (pt.disagreements ? ", DISAGREE" : ", same verdicts") << ")\n";
+	}
+	cout << '\n';
 
 	//////////////////////////////////////////////  That's all folks	
 	return endProgram(0);